@@ -0,0 +1,60 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Minimal timing helpers shared by the microbenchmarks in bench/.
+// Each benchmark is run `reps` times and the fastest run is reported.
+template <typename Fn>
+double benchBest(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int i = 0; i < reps; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (seconds < best) {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+inline void benchReport(const std::string& name, double seconds, double items, const char* unit) {
+    std::printf("  %-36s %10.3f ms  %12.0f %s/s\n", name.c_str(), seconds * 1e3, items / seconds, unit);
+}
+
+// Generates a large, valid SYSY translation unit resembling our generated
+// sources: many small functions with comments, loops and arithmetic.
+inline std::string generateSource(int functions) {
+    std::string source = "int counter;\n";
+    for (int f = 0; f < functions; f++) {
+        std::string n = std::to_string(f);
+        source += "/* generated kernel " + n + "\n * accumulates a running sum\n */\n";
+        source += "int kernel_" + n + "(int base, int limit) {\n";
+        source += "    int index = 0;\n";
+        source += "    int total = base;  // running total\n";
+        source += "    while (index < limit) {\n";
+        source += "        if (index % 3 == 0 && total != 7) {\n";
+        source += "            total = total + index * " + std::to_string(f % 97 + 2) + " - 1;\n";
+        source += "        } else {\n";
+        source += "            total = total - (index + base) / 2;\n";
+        source += "        }\n";
+        source += "        index = index + 1;\n";
+        source += "    }\n";
+        if (f > 0) {
+            source += "    total = total + kernel_" + std::to_string(f - 1) + "(total, 4);\n";
+        }
+        source += "    return total;\n";
+        source += "}\n\n";
+    }
+    source += "int main() {\n    return kernel_" + std::to_string(functions - 1) + "(1, 10);\n}\n";
+    return source;
+}
+
+// Sink that keeps the optimizer from discarding benchmarked work
+inline volatile long bench_sink = 0;
+
+#endif // BENCH_H
@@ -0,0 +1,92 @@
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "bench.h"
+#include "batch_compiler.h"
+
+extern char** environ;
+
+// Files per second compiling the examples: one process per file, as the
+// Makefile `examples` target runs sysyc, against one BatchCompiler. The
+// per-process side re-runs this binary with `--compile`, so both sides
+// are the same optimized build of the compiler.
+static int compileOne(const char* input, const char* output) {
+    ThreadPool pool(1);
+    BatchCompiler compiler(pool, true);
+    std::vector<BatchCompiler::Unit> units(1);
+    units[0].input = input;
+    units[0].output = output;
+    return compiler.compile(units) == 0 ? 0 : 1;
+}
+
+static void spawnCompiler(const std::string& input, const std::string& output) {
+    std::string self = std::filesystem::read_symlink("/proc/self/exe").string();
+    std::vector<char*> argv{const_cast<char*>(self.c_str()), const_cast<char*>("--compile"),
+                            const_cast<char*>(input.c_str()), const_cast<char*>(output.c_str()), nullptr};
+    pid_t pid;
+    int status;
+    if (posix_spawn(&pid, self.c_str(), nullptr, nullptr, argv.data(), environ) != 0 ||
+        waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "compiling " << input << " failed\n";
+        std::exit(1);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 4 && std::strcmp(argv[1], "--compile") == 0) {
+        return compileOne(argv[2], argv[3]);
+    }
+
+    std::filesystem::path out = std::filesystem::temp_directory_path() /
+                                ("sysyc_bench_batch_" + std::to_string(getpid()));
+    std::filesystem::create_directories(out);
+    std::vector<std::string> inputs;
+    for (const auto& entry : std::filesystem::directory_iterator("examples")) {
+        if (entry.path().extension() == ".sy") {
+            inputs.push_back(entry.path().string());
+        }
+    }
+    // Plus some larger units, so the batch is not all tiny files
+    for (int i = 1; i <= 8; i++) {
+        std::string path = (out / ("generated" + std::to_string(i) + ".sy")).string();
+        std::ofstream(path) << generateSource(i * 40);
+        inputs.push_back(path);
+    }
+    std::vector<BatchCompiler::Unit> units(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        units[i].input = inputs[i];
+        units[i].output = BatchCompiler::outputPath(inputs[i], out.string());
+    }
+    double files = static_cast<double>(units.size());
+
+    std::cout << "Batch compilation (" << units.size() << " files, "
+              << std::thread::hardware_concurrency() << " hardware threads)\n";
+    double time = benchBest(3, [&] {
+        for (const BatchCompiler::Unit& unit : units) {
+            spawnCompiler(unit.input, unit.output);
+        }
+    });
+    benchReport("One process per file", time, files, "files");
+    for (size_t threads : {1, 2, 4}) {
+        ThreadPool pool(threads);
+        time = benchBest(3, [&] {
+            BatchCompiler compiler(pool, true);
+            std::vector<BatchCompiler::Unit> batch = units;
+            if (compiler.compile(batch) != 0) {
+                std::abort();
+            }
+            bench_sink = static_cast<long>(batch.size());
+        });
+        benchReport("BatchCompiler, " + std::to_string(threads) + " threads", time, files, "files");
+    }
+    std::filesystem::remove_all(out);
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <string>
+#include "bench.h"
+#include "lexer.h"
+#include "parser.h"
+#include "flat_ast.h"
+#include "ir_generator.h"
+
+int main() {
+    std::string source = generateSource(5000);
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto program = parser.parse();
+
+    size_t instructions = 0;
+    {
+        IRGenerator generator;
+        for (const IRFunction& func : generator.generate(program.get()).functions) {
+            instructions += func.instructions.size();
+        }
+    }
+    FlatAST flat = FlatAST::build(*program);
+
+    std::cout << "IR generation (" << program->declarations.size() << " declarations, "
+              << instructions << " instructions, " << flat.nodes.size() << " nodes)\n";
+    double time = benchBest(5, [&] {
+        IRGenerator generator;
+        bench_sink = static_cast<long>(generator.generate(program.get()).functions.size());
+    });
+    benchReport("IRGenerator (AST visitor)", time, static_cast<double>(instructions), "instrs");
+
+    time = benchBest(5, [&] {
+        bench_sink = static_cast<long>(FlatAST::build(*program).nodes.size());
+    });
+    benchReport("FlatAST::build", time, static_cast<double>(flat.nodes.size()), "nodes");
+
+    // Walk only, without emitting IR: isolates the traversal itself
+    time = benchBest(5, [&] {
+        long kinds = 0;
+        for (const FlatNode& node : flat.nodes) {
+            kinds += static_cast<long>(node.kind);
+        }
+        bench_sink = kinds;
+    });
+    benchReport("FlatAST linear scan", time, static_cast<double>(flat.nodes.size()), "nodes");
+    return 0;
+}
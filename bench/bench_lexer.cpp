@@ -0,0 +1,136 @@
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "bench.h"
+#include "lexer.h"
+#include "scan.h"
+#include "parallel_lexer.h"
+
+// Keyword classification as Lexer::identifier() used to do it: a keyword
+// table built per Lexer and an identifier string built char-by-char.
+static long classifyWithMap(const std::string& source) {
+    std::unordered_map<std::string, TokenType> keywords;
+    keywords["const"] = TokenType::CONST;
+    keywords["int"] = TokenType::INT;
+    keywords["void"] = TokenType::VOID;
+    keywords["char"] = TokenType::CHAR;
+    keywords["typedef"] = TokenType::TYPEDEF;
+    keywords["if"] = TokenType::IF;
+    keywords["else"] = TokenType::ELSE;
+    keywords["while"] = TokenType::WHILE;
+    keywords["break"] = TokenType::BREAK;
+    keywords["continue"] = TokenType::CONTINUE;
+    keywords["return"] = TokenType::RETURN;
+
+    long keyword_count = 0;
+    size_t i = 0;
+    while (i < source.size()) {
+        if (!std::isalpha(source[i]) && source[i] != '_') {
+            i++;
+            continue;
+        }
+        std::string id_str;
+        while (i < source.size() && (std::isalnum(source[i]) || source[i] == '_')) {
+            id_str += source[i++];
+        }
+        auto it = keywords.find(id_str);
+        if (it != keywords.end()) {
+            keyword_count++;
+        }
+    }
+    return keyword_count;
+}
+
+static long classifyWithSwitch(const std::string& source) {
+    std::string_view view(source);
+    long keyword_count = 0;
+    size_t i = 0;
+    while (i < view.size()) {
+        if (!std::isalpha(view[i]) && view[i] != '_') {
+            i++;
+            continue;
+        }
+        size_t start = i;
+        while (i < view.size() && (std::isalnum(view[i]) || view[i] == '_')) {
+            i++;
+        }
+        if (lookupKeyword(view.substr(start, i - start)) != TokenType::IDENT) {
+            keyword_count++;
+        }
+    }
+    return keyword_count;
+}
+
+int main() {
+    std::string source = generateSource(5000);
+
+    long identifiers = 0;
+    for (const Token& token : Lexer(source).tokenize()) {
+        if (token.type == TokenType::IDENT || lookupKeyword(token.lexeme) != TokenType::IDENT) {
+            identifiers++;
+        }
+    }
+
+    std::cout << "Keyword classification (" << identifiers << " identifiers, "
+              << source.size() / 1024 << " KiB)\n";
+
+    double map_time = benchBest(5, [&] { bench_sink = classifyWithMap(source); });
+    benchReport("unordered_map + std::string (old)", map_time, identifiers, "idents");
+
+    double switch_time = benchBest(5, [&] { bench_sink = classifyWithSwitch(source); });
+    benchReport("lookupKeyword switch", switch_time, identifiers, "idents");
+
+    // Comment-heavy input: doc blocks and indentation dominate the bytes
+    std::string commented;
+    for (int i = 0; i < 20000; i++) {
+        commented += "/**\n * " + std::string(60, '=') + "\n * Generated helper\n */\n";
+        commented += "        int value_" + std::to_string(i) + " = 42;   // " + std::string(40, '.') + "\n";
+    }
+    
+    std::cout << "Lexer::tokenize by scan implementation\n";
+    for (scan::Impl impl : {scan::Impl::SCALAR, scan::Impl::SSE2, scan::Impl::AVX2}) {
+        if (!scan::setImpl(impl)) {
+            continue;
+        }
+        double lex_time = benchBest(5, [&] {
+            Lexer lexer(source);
+            bench_sink = static_cast<long>(lexer.tokenize().size());
+        });
+        benchReport(std::string(scan::implName(impl)) + " (generated)", lex_time,
+                    static_cast<double>(source.size()), "bytes");
+        double comment_time = benchBest(5, [&] {
+            Lexer lexer(commented);
+            bench_sink = static_cast<long>(lexer.tokenize().size());
+        });
+        benchReport(std::string(scan::implName(impl)) + " (comment-heavy)", comment_time,
+                    static_cast<double>(commented.size()), "bytes");
+    }
+    scan::setImpl(scan::Impl::AVX2) || scan::setImpl(scan::Impl::SSE2);
+
+    std::string large = generateSource(40000);
+    size_t expected_tokens = Lexer(large).tokenize().size();
+    std::cout << "ParallelLexer (" << large.size() / (1024 * 1024) << " MiB, "
+              << std::thread::hardware_concurrency() << " hardware threads)\n";
+    double serial_time = benchBest(3, [&] {
+        Lexer lexer(large);
+        bench_sink = static_cast<long>(lexer.tokenize().size());
+    });
+    benchReport("Lexer::tokenize", serial_time, static_cast<double>(large.size()), "bytes");
+    for (size_t threads : {2, 4, 8}) {
+        ThreadPool pool(threads);
+        double parallel_time = benchBest(3, [&] {
+            ParallelLexer lexer(large, pool);
+            size_t count = lexer.tokenize().size();
+            if (count != expected_tokens) {
+                std::abort();
+            }
+            bench_sink = static_cast<long>(count);
+        });
+        benchReport("ParallelLexer, " + std::to_string(threads) + " threads", parallel_time,
+                    static_cast<double>(large.size()), "bytes");
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <string>
+#include "bench.h"
+#include "lexer.h"
+#include "parser.h"
+#include "ir_generator.h"
+#include "optimizer.h"
+#include "codegen.h"
+
+int main() {
+    std::string source = generateSource(5000);
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto program = parser.parse();
+    IRGenerator generator;
+    IRModule module = generator.generate(program.get());
+    IRModule optimized = Optimizer().optimize(module);
+
+    size_t instructions = 0;
+    for (const IRFunction& func : module.functions) {
+        instructions += func.instructions.size();
+    }
+    size_t optimized_instructions = 0;
+    for (const IRFunction& func : optimized.functions) {
+        optimized_instructions += func.instructions.size();
+    }
+
+    std::cout << "Back end (" << module.functions.size() << " functions, " << instructions
+              << " instructions)\n";
+    double time = benchBest(5, [&] {
+        Optimizer optimizer;
+        bench_sink = static_cast<long>(optimizer.optimize(module).functions.size());
+    });
+    benchReport("Optimizer", time, static_cast<double>(instructions), "instrs");
+
+    time = benchBest(5, [&] {
+        CodeGenerator codegen;
+        bench_sink = static_cast<long>(codegen.generate(optimized).size());
+    });
+    benchReport("CodeGenerator", time, static_cast<double>(optimized_instructions), "instrs");
+
+    std::string expected = CodeGenerator().generate(optimized);
+    std::cout << "Back end, -j (" << std::thread::hardware_concurrency() << " hardware threads)\n";
+    for (size_t threads : {2, 4, 8}) {
+        ThreadPool pool(threads);
+        time = benchBest(5, [&] {
+            Optimizer optimizer;
+            bench_sink = static_cast<long>(optimizer.optimize(module, pool).functions.size());
+        });
+        benchReport("Optimizer, " + std::to_string(threads) + " threads", time,
+                    static_cast<double>(instructions), "instrs");
+        time = benchBest(5, [&] {
+            CodeGenerator codegen;
+            std::string assembly = codegen.generate(optimized, pool);
+            if (assembly != expected) {
+                std::abort();
+            }
+            bench_sink = static_cast<long>(assembly.size());
+        });
+        benchReport("CodeGenerator, " + std::to_string(threads) + " threads", time,
+                    static_cast<double>(optimized_instructions), "instrs");
+    }
+    return 0;
+}
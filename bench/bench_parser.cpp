@@ -0,0 +1,126 @@
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include "bench.h"
+#include "lexer.h"
+#include "parser.h"
+#include "incremental_parser.h"
+#include "parallel_parser.h"
+
+// Counts heap allocations made by the benchmarked code
+static size_t heap_allocations = 0;
+
+void* operator new(size_t size) {
+    heap_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+int main() {
+    std::string source = generateSource(5000);
+    std::vector<Token> token_vector = Lexer(source).tokenize();
+    TokenBuffer packed = Lexer(source).tokenizePacked();
+    double token_count = static_cast<double>(packed.size());
+
+    std::cout << "Token storage (" << packed.size() << " tokens, " << source.size() / 1024 << " KiB)\n";
+    std::printf("  %-36s %10zu bytes/token\n", "std::vector<Token>", sizeof(Token));
+    std::printf("  %-36s %10.1f bytes/token\n", "TokenBuffer (packed)", packed.memoryUsage() / token_count);
+
+    std::cout << "Parse throughput\n";
+    double vector_time = benchBest(5, [&] {
+        Parser parser(token_vector);
+        bench_sink = static_cast<long>(parser.parse()->declarations.size());
+    });
+    benchReport("Parser(std::vector<Token>)", vector_time, token_count, "tokens");
+
+    double packed_time = benchBest(5, [&] {
+        Parser parser(packed);
+        bench_sink = static_cast<long>(parser.parse()->declarations.size());
+    });
+    benchReport("Parser(TokenBuffer)", packed_time, token_count, "tokens");
+
+    double recovering_time = benchBest(5, [&] {
+        Parser parser(packed);
+        std::vector<std::string> errors;
+        bench_sink = static_cast<long>(parser.parse(errors)->declarations.size() + errors.size());
+    });
+    benchReport("Parser(TokenBuffer), recovering", recovering_time, token_count, "tokens");
+
+    double stream_time = benchBest(5, [&] {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        bench_sink = static_cast<long>(parser.parse()->declarations.size());
+    });
+    benchReport("Lexer -> Parser (streaming, incl. lex)", stream_time, token_count, "tokens");
+
+    std::cout << "ParallelParser (" << std::thread::hardware_concurrency() << " hardware threads)\n";
+    for (size_t threads : {2, 4, 8}) {
+        ThreadPool pool(threads);
+        double parallel_time = benchBest(5, [&] {
+            ParallelParser parser(packed, pool);
+            bench_sink = static_cast<long>(parser.parse()->declarations.size());
+        });
+        benchReport("ParallelParser, " + std::to_string(threads) + " threads", parallel_time, token_count, "tokens");
+    }
+
+    std::cout << "AST allocation (parse from tokens, then destroy)\n";
+    size_t before = heap_allocations;
+    {
+        Parser parser(token_vector);
+        auto program = parser.parse();
+    }
+    std::printf("  %-36s %10zu\n", "heap allocations", heap_allocations - before);
+    double parse_destroy_time = benchBest(5, [&] {
+        Parser parser(token_vector);
+        auto program = parser.parse();
+        bench_sink = static_cast<long>(program->declarations.size());
+    });
+    double destroy_time = 0;
+    for (int i = 0; i < 5; i++) {
+        Parser parser(token_vector);
+        auto program = parser.parse();
+        double t = benchBest(1, [&] { program.reset(); });
+        destroy_time = i == 0 || t < destroy_time ? t : destroy_time;
+    }
+    benchReport("parse + destroy", parse_destroy_time, token_count, "tokens");
+    benchReport("destroy only", destroy_time, token_count, "tokens");
+
+    // Editor-style edits: one keystroke inside a function of a ~50k line file
+    std::string document = generateSource(3000);
+    size_t lines = 0;
+    for (char c : document) {
+        lines += c == '\n';
+    }
+    std::cout << "Edit latency (" << lines << " lines)\n";
+    double full_time = benchBest(5, [&] {
+        Lexer lexer(document);
+        Parser parser(lexer);
+        bench_sink = static_cast<long>(parser.parse()->declarations.size());
+    });
+    benchReport("full re-lex + re-parse", full_time, 1, "edits");
+
+    IncrementalParser incremental(document);
+    size_t at = document.find("index * ", document.size() / 2) + 8;
+    const int edits = 1000;
+    double edit_time = benchBest(5, [&] {
+        for (int i = 0; i < edits; i++) {
+            incremental.applyEdit(TextEdit{at, 0, "1"});
+            incremental.applyEdit(TextEdit{at, 1, ""});
+        }
+    }) / (2 * edits);
+    benchReport("IncrementalParser::applyEdit", edit_time, 1, "edits");
+    std::printf("  %-36s %10zu bytes\n", "re-parsed per edit", incremental.lastReparsedBytes());
+    return 0;
+}
@@ -0,0 +1,193 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator. Memory is carved out of large blocks and released all at
+// once when the arena is destroyed or reset; individual allocations are
+// never freed and objects placed in an arena never have their destructors
+// run, so only put trivially destructible data (or data whose destructor
+// does nothing but free arena memory) here.
+class Arena {
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t current_block;
+    char* cursor;
+    char* limit;
+    size_t block_size;
+    size_t allocation_count;
+
+    void* allocateSlow(size_t size, size_t align) {
+        // Reuse blocks kept by reset() before allocating new ones
+        while (current_block + 1 < blocks.size()) {
+            current_block++;
+            cursor = blocks[current_block].data.get();
+            limit = cursor + blocks[current_block].size;
+            if (void* result = tryAllocate(size, align)) {
+                return result;
+            }
+        }
+        size_t needed = size + align;
+        size_t new_size = needed > block_size ? needed : block_size;
+        blocks.push_back(Block{std::unique_ptr<char[]>(new char[new_size]), new_size});
+        current_block = blocks.size() - 1;
+        cursor = blocks.back().data.get();
+        limit = cursor + new_size;
+        return tryAllocate(size, align);
+    }
+
+    void* tryAllocate(size_t size, size_t align) {
+        size_t address = reinterpret_cast<size_t>(cursor);
+        size_t padding = (align - (address & (align - 1))) & (align - 1);
+        if (cursor == nullptr || static_cast<size_t>(limit - cursor) < size + padding) {
+            return nullptr;
+        }
+        char* result = cursor + padding;
+        cursor = result + size;
+        return result;
+    }
+
+    // Forgets every block, after they were moved elsewhere
+    void release() {
+        blocks.clear();
+        current_block = 0;
+        cursor = nullptr;
+        limit = nullptr;
+        allocation_count = 0;
+    }
+
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit Arena(size_t block_size = DEFAULT_BLOCK_SIZE)
+        : current_block(0), cursor(nullptr), limit(nullptr),
+          block_size(block_size), allocation_count(0) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    // The source is left empty, ready to allocate blocks of its own
+    Arena(Arena&& other) noexcept
+        : blocks(std::move(other.blocks)), current_block(other.current_block), cursor(other.cursor),
+          limit(other.limit), block_size(other.block_size), allocation_count(other.allocation_count) {
+        other.release();
+    }
+    Arena& operator=(Arena&& other) noexcept {
+        if (this != &other) {
+            blocks = std::move(other.blocks);
+            current_block = other.current_block;
+            cursor = other.cursor;
+            limit = other.limit;
+            block_size = other.block_size;
+            allocation_count = other.allocation_count;
+            other.release();
+        }
+        return *this;
+    }
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        allocation_count++;
+        if (void* result = tryAllocate(size, align)) {
+            return result;
+        }
+        return allocateSlow(size, align);
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    std::string_view copyString(std::string_view text) {
+        char* data = static_cast<char*>(allocate(text.size() + 1, 1));
+        std::memcpy(data, text.data(), text.size());
+        data[text.size()] = '\0';
+        return std::string_view(data, text.size());
+    }
+
+    // Releases every allocation but keeps the blocks for reuse
+    void reset() {
+        current_block = 0;
+        cursor = blocks.empty() ? nullptr : blocks[0].data.get();
+        limit = blocks.empty() ? nullptr : cursor + blocks[0].size;
+        allocation_count = 0;
+    }
+
+    // Takes over every block of `other`, which is left empty. Allocations
+    // made from `other` stay valid and are now released with this arena.
+    void adopt(Arena& other) {
+        size_t count = other.blocks.size();
+        // Before the current block, so allocateSlow never hands them out again
+        blocks.insert(blocks.begin() + current_block,
+                      std::make_move_iterator(other.blocks.begin()),
+                      std::make_move_iterator(other.blocks.end()));
+        current_block += count;
+        allocation_count += other.allocation_count;
+        other.release();
+    }
+
+    size_t allocationCount() const { return allocation_count; }
+
+    size_t bytesReserved() const {
+        size_t total = 0;
+        for (const auto& block : blocks) {
+            total += block.size;
+        }
+        return total;
+    }
+};
+
+// Growable array whose storage comes from an Arena. Growing copies the
+// elements into a larger arena allocation and abandons the old one, which
+// the arena reclaims when it is released. Elements are never destroyed.
+template <typename T>
+class ArenaVector {
+    static_assert(std::is_trivially_destructible<T>::value, "ArenaVector never destroys its elements");
+
+private:
+    T* items;
+    size_t count;
+    size_t capacity;
+
+    void grow(Arena& arena) {
+        size_t new_capacity = capacity == 0 ? 4 : capacity * 2;
+        T* fresh = static_cast<T*>(arena.allocate(new_capacity * sizeof(T), alignof(T)));
+        for (size_t i = 0; i < count; i++) {
+            new (&fresh[i]) T(items[i]);
+        }
+        items = fresh;
+        capacity = new_capacity;
+    }
+
+public:
+    ArenaVector() : items(nullptr), count(0), capacity(0) {}
+
+    void push_back(Arena& arena, const T& value) {
+        if (count == capacity) {
+            grow(arena);
+        }
+        new (&items[count++]) T(value);
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t index) { return items[index]; }
+    const T& operator[](size_t index) const { return items[index]; }
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+};
+
+#endif // ARENA_H
@@ -1,9 +1,12 @@
 #ifndef AST_H
 #define AST_H
 
-#include <string>
+#include <cstdint>
+#include <string_view>
+#include <utility>
 #include <vector>
-#include <memory>
+#include "arena.h"
+#include "symbol.h"
 
 // Forward declarations
 class ASTVisitor;
@@ -30,10 +33,28 @@ enum class ASTNodeType {
     ARRAY_ACCESS
 };
 
+// Nodes are allocated in the arena of the Program they belong to and are
+// released with it all at once: children are plain pointers, lists are
+// ArenaVectors and text is a view of arena (or static) memory, so no node
+// needs a destructor.
+// Operators are decided by the parser from the token it matched; the order
+// of the arithmetic, comparison and logical entries follows IROpcode.
+enum class BinaryOp : uint8_t {
+    ADD, SUB, MUL, DIV, MOD,
+    EQ, NE, LT, LE, GT, GE,
+    AND, OR,
+    ASSIGN
+};
+
+enum class UnaryOp : uint8_t {
+    PLUS, MINUS, NOT,
+    ADDRESS_OF, DEREFERENCE,
+    INCREMENT, DECREMENT
+};
+
 class ASTNode {
 public:
     ASTNodeType type;
-    virtual ~ASTNode() = default;
     virtual void accept(ASTVisitor* visitor) = 0;
 };
 
@@ -58,131 +79,135 @@ public:
 
 class StringLiteralExpr : public Expression {
 public:
-    std::string value;
-    StringLiteralExpr(const std::string& value);
+    std::string_view value;
+    StringLiteralExpr(std::string_view value);
     void accept(ASTVisitor* visitor) override;
 };
 
 class IdentExpr : public Expression {
 public:
-    std::string name;
-    IdentExpr(const std::string& name);
+    Symbol name;
+    IdentExpr(Symbol name);
     void accept(ASTVisitor* visitor) override;
 };
 
 class BinaryExpr : public Expression {
 public:
-    std::string op;
-    std::unique_ptr<Expression> left;
-    std::unique_ptr<Expression> right;
-    BinaryExpr(const std::string& op, std::unique_ptr<Expression> left, 
-               std::unique_ptr<Expression> right);
+    BinaryOp op;
+    Expression* left;
+    Expression* right;
+    BinaryExpr(BinaryOp op, Expression* left, Expression* right);
     void accept(ASTVisitor* visitor) override;
 };
 
 class UnaryExpr : public Expression {
 public:
-    std::string op;
-    std::unique_ptr<Expression> operand;
-    UnaryExpr(const std::string& op, std::unique_ptr<Expression> operand);
+    UnaryOp op;
+    Expression* operand;
+    UnaryExpr(UnaryOp op, Expression* operand);
     void accept(ASTVisitor* visitor) override;
 };
 
 class CallExpr : public Expression {
 public:
-    std::string func_name;
-    std::vector<std::unique_ptr<Expression>> args;
-    CallExpr(const std::string& func_name);
+    Symbol func_name;
+    ArenaVector<Expression*> args;
+    CallExpr(Symbol func_name);
     void accept(ASTVisitor* visitor) override;
 };
 
 class ArrayAccess : public Expression {
 public:
-    std::string array_name;
-    std::unique_ptr<Expression> index;
-    ArrayAccess(const std::string& array_name, std::unique_ptr<Expression> index);
+    Symbol array_name;
+    Expression* index;
+    ArrayAccess(Symbol array_name, Expression* index);
     void accept(ASTVisitor* visitor) override;
 };
 
 // Statements
 class ExprStmt : public Statement {
 public:
-    std::unique_ptr<Expression> expr;
-    ExprStmt(std::unique_ptr<Expression> expr);
+    Expression* expr;
+    ExprStmt(Expression* expr);
     void accept(ASTVisitor* visitor) override;
 };
 
 class Block : public Statement {
 public:
-    std::vector<std::unique_ptr<Statement>> statements;
+    ArenaVector<Statement*> statements;
+    Block();
     void accept(ASTVisitor* visitor) override;
 };
 
 class IfStmt : public Statement {
 public:
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<Statement> then_stmt;
-    std::unique_ptr<Statement> else_stmt;
-    IfStmt(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> then_stmt,
-           std::unique_ptr<Statement> else_stmt = nullptr);
+    Expression* condition;
+    Statement* then_stmt;
+    Statement* else_stmt;
+    IfStmt(Expression* condition, Statement* then_stmt,
+           Statement* else_stmt = nullptr);
     void accept(ASTVisitor* visitor) override;
 };
 
 class WhileStmt : public Statement {
 public:
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<Statement> body;
-    WhileStmt(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> body);
+    Expression* condition;
+    Statement* body;
+    WhileStmt(Expression* condition, Statement* body);
     void accept(ASTVisitor* visitor) override;
 };
 
 class ReturnStmt : public Statement {
 public:
-    std::unique_ptr<Expression> value;
-    ReturnStmt(std::unique_ptr<Expression> value = nullptr);
+    Expression* value;
+    ReturnStmt(Expression* value = nullptr);
     void accept(ASTVisitor* visitor) override;
 };
 
 class BreakStmt : public Statement {
 public:
+    BreakStmt();
     void accept(ASTVisitor* visitor) override;
 };
 
 class ContinueStmt : public Statement {
 public:
+    ContinueStmt();
     void accept(ASTVisitor* visitor) override;
 };
 
 class VarDecl : public Statement {
 public:
-    std::string name;
-    std::string var_type;  // "int", "char", "void", or "int*", "char*", etc.
+    Symbol name;
+    std::string_view var_type;  // "int", "char", "void", or "int*", "char*", etc.
     bool is_const;
     bool is_array;
     int array_size;
     int pointer_level;  // 0 for non-pointer, 1 for *, 2 for **, etc.
-    std::unique_ptr<Expression> init_value;
-    VarDecl(const std::string& name, const std::string& var_type = "int", bool is_const = false, 
+    Expression* init_value;
+    VarDecl(Symbol name, std::string_view var_type = "int", bool is_const = false, 
             bool is_array = false, int array_size = 0, int pointer_level = 0,
-            std::unique_ptr<Expression> init_value = nullptr);
+            Expression* init_value = nullptr);
     void accept(ASTVisitor* visitor) override;
 };
 
 // Function definition
 class FunctionDef : public ASTNode {
 public:
-    std::string name;
-    std::string return_type;
-    std::vector<std::pair<std::string, std::string>> params;  // (type, name)
-    std::unique_ptr<Block> body;
-    FunctionDef(const std::string& name, const std::string& return_type);
+    Symbol name;
+    std::string_view return_type;
+    ArenaVector<std::pair<std::string_view, Symbol>> params;  // (type, name)
+    Block* body;
+    FunctionDef(Symbol name, std::string_view return_type);
     void accept(ASTVisitor* visitor) override;
 };
 
 // Program (root node)
 class Program : public ASTNode {
 public:
-    std::vector<std::unique_ptr<ASTNode>> declarations;
+    Arena arena;  // owns every node of the tree
+    std::vector<ASTNode*> declarations;
+    Program();
     void accept(ASTVisitor* visitor) override;
 };
 
@@ -0,0 +1,63 @@
+#ifndef BATCH_COMPILER_H
+#define BATCH_COMPILER_H
+
+#include "arena.h"
+#include "ir_cache.h"
+#include "stats.h"
+#include "thread_pool.h"
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compiles many translation units in one process (sysyc @filelist, or
+// several inputs). Units are spread over a ThreadPool, largest file
+// first, and each runs the whole pipeline on one thread. Every AST is
+// built in an arena left over from an earlier unit, so once each thread
+// has warmed up, parsing reuses memory instead of allocating blocks.
+// Errors are kept per unit for the caller to report in input order, so
+// neither diagnostics nor output files depend on scheduling.
+class BatchCompiler {
+public:
+    struct Unit {
+        std::string input;
+        std::string output;
+        bool ok = false;
+        std::vector<std::string> errors;
+    };
+
+    BatchCompiler(ThreadPool& pool, bool optimize);
+
+    // Both optional; null turns them off
+    void setCache(IRCache* cache) { this->cache = cache; }
+    void setStats(CompileStats* stats) { this->stats = stats; }
+
+    // Compiles every unit, setting ok or filling in errors. Returns the
+    // number of units that failed. Units whose outputs are the same file
+    // all fail without being compiled.
+    size_t compile(std::vector<Unit>& units);
+    // Source to assembly, as compiling one file does. Returns false
+    // after appending syntax errors to `errors`; semantic errors throw.
+    bool compileSource(std::string_view source, std::string& assembly, std::vector<std::string>& errors);
+
+    // `input` with .sy replaced by .s, placed in `directory` if it is set
+    static std::string outputPath(const std::string& input, const std::string& directory);
+    // One path per line; blank lines and lines starting with '#' are skipped
+    static std::vector<std::string> readFileList(const std::string& path);
+    // Arenas of finished units waiting to be reused
+    size_t spareArenaCount() const;
+
+private:
+    ThreadPool& pool;
+    bool optimize;
+    IRCache* cache;
+    CompileStats* stats;
+    mutable std::mutex arenas_mutex;
+    std::vector<Arena> arenas;  // from finished units, ready for reuse
+
+    void compileUnit(Unit& unit);
+    Arena takeArena();
+    void returnArena(Arena arena);
+};
+
+#endif // BATCH_COMPILER_H
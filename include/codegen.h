@@ -2,25 +2,31 @@
 #define CODEGEN_H
 
 #include "ir.h"
+#include "thread_pool.h"
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <vector>
 #include <sstream>
 
 class CodeGenerator {
 private:
-    std::map<std::string, int> var_offsets;
+    std::unordered_map<Operand, int> var_offsets;
     int stack_offset;
     
     void generatePrologue(const IRFunction& func);
     void generateEpilogue();
     void generateInstruction(const IRInstruction& instr);
-    int getVarOffset(const std::string& var);
-    void allocateVar(const std::string& var, int size);
+    int getVarOffset(Operand var);
+    void loadOperand(std::ostringstream& out, Operand operand, const char* reg);
+    void allocateVar(Operand var, int size);
     
 public:
     CodeGenerator();
     std::string generate(const IRModule& module);
+    // Emits the functions concurrently on the pool, each with its own
+    // generator, and joins them in module order: the text is the same as
+    // generate(module)
+    std::string generate(const IRModule& module, ThreadPool& pool);
     std::string generateFunction(const IRFunction& func);
 };
 
@@ -0,0 +1,32 @@
+#ifndef DOMINATORS_H
+#define DOMINATORS_H
+
+#include <vector>
+#include "ir.h"
+
+// Dominator tree and dominance frontiers of an IRFunction's CFG, computed
+// with the Cooper-Harvey-Kennedy iterative algorithm over reverse
+// postorder. Blocks unreachable from the entry have no immediate dominator
+// and are neither dominated by nor dominate anything.
+class DominatorTree {
+private:
+    std::vector<int> idoms;                   // -1 for the entry and unreachable blocks
+    std::vector<std::vector<int>> child_lists;
+    std::vector<std::vector<int>> frontiers;
+    std::vector<int> rpo;                     // reachable blocks in reverse postorder
+    std::vector<int> rpo_index;               // position in rpo, -1 if unreachable
+    std::vector<int> tree_in, tree_out;       // preorder interval in the tree
+
+public:
+    explicit DominatorTree(const IRFunction& func);
+
+    int idom(int block) const { return idoms[static_cast<size_t>(block)]; }
+    const std::vector<int>& children(int block) const { return child_lists[static_cast<size_t>(block)]; }
+    const std::vector<int>& frontier(int block) const { return frontiers[static_cast<size_t>(block)]; }
+    const std::vector<int>& reversePostorder() const { return rpo; }
+    bool reachable(int block) const { return rpo_index[static_cast<size_t>(block)] >= 0; }
+    // Whether every path from the entry to b passes through a (a dominates itself)
+    bool dominates(int a, int b) const;
+};
+
+#endif // DOMINATORS_H
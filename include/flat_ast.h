@@ -0,0 +1,67 @@
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "ast.h"
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Compact, pointer-free copy of a Program for passes that walk the whole
+// tree. All nodes live in one vector and refer to each other by 32-bit
+// index (0 means "none"); child lists are runs of indices in `lists`.
+// Nodes are laid out in pre-order, so a traversal reads memory forwards.
+//
+// Field use per kind:
+//   INT_LITERAL_EXPR, CHAR_LITERAL_EXPR   value
+//   STRING_LITERAL_EXPR                   a = index into strings
+//   IDENT_EXPR                            name
+//   BINARY_EXPR, UNARY_EXPR               op, a = left/operand, b = right
+//   CALL_EXPR                             name, a/b = argument list
+//   ARRAY_ACCESS                          name, a = index
+//   EXPR_STMT, RETURN_STMT                a = expression (or 0)
+//   BLOCK                                 a/b = statement list
+//   IF_STMT                               a = condition, b = then, c = else (or 0)
+//   WHILE_STMT                            a = condition, b = body
+//   VAR_DECL                              name, op = VAR_* flags, value = array
+//                                         size, a = initializer (or 0),
+//                                         b = pointer level, c = type in strings
+//   FUNCTION_DEF                          name, a/b = range in params,
+//                                         c = body, value = return type in strings
+// where a/b = list means a is the first entry in `lists` and b the count.
+struct FlatNode {
+    ASTNodeType kind;
+    uint8_t op;
+    Symbol name;
+    int32_t value;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+};
+
+class FlatAST {
+public:
+    static constexpr uint8_t VAR_CONST = 1;
+    static constexpr uint8_t VAR_ARRAY = 2;
+
+    std::vector<FlatNode> nodes;                               // nodes[0] is unused
+    std::vector<uint32_t> lists;
+    std::vector<std::string_view> strings;                     // views into the Program's arena
+    std::vector<std::pair<std::string_view, Symbol>> params;   // (type, name)
+    std::vector<uint32_t> declarations;                        // top-level nodes
+
+    // The Program must outlive the FlatAST, which refers to its text
+    static FlatAST build(const Program& program);
+
+    const FlatNode& operator[](uint32_t index) const { return nodes[index]; }
+    // Entries of the child list of `node` (BLOCK and CALL_EXPR)
+    const uint32_t* listBegin(const FlatNode& node) const { return lists.data() + node.a; }
+    const uint32_t* listEnd(const FlatNode& node) const { return lists.data() + node.a + node.b; }
+
+private:
+    uint32_t add(const FlatNode& node);
+    uint32_t addString(std::string_view text);
+    uint32_t flatten(const ASTNode* node);
+};
+
+#endif // FLAT_AST_H
@@ -0,0 +1,64 @@
+#ifndef INCREMENTAL_PARSER_H
+#define INCREMENTAL_PARSER_H
+
+#include "ast.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Replace `length` bytes at byte `offset` with `text`
+struct TextEdit {
+    size_t offset;
+    size_t length;
+    std::string text;
+};
+
+// Keeps a Program up to date while its source is edited, e.g. on every
+// keystroke in an editor. The source is held as one segment per top-level
+// declaration (the declaration plus the trivia after it), so an edit only
+// re-lexes and re-parses the segments it touches and splices the new
+// declarations into Program::declarations; all other subtrees are reused.
+// Nodes of a re-parsed segment live in that segment's own arena, which is
+// released when the segment is next replaced.
+//
+// An edit that cannot be handled locally (the segment no longer parses on
+// its own, or now ends inside a comment or in the middle of a token) falls
+// back to parsing the whole source, which also yields the same error a
+// full Parser run would.
+class IncrementalParser {
+private:
+    struct Segment {
+        std::string text;
+        size_t declarations;   // entries in Program::declarations it produced
+        // Arena of a local re-parse holding those declarations; null if they
+        // live in the arena of `program` itself
+        std::unique_ptr<Program> tree;
+    };
+
+    std::vector<Segment> segments;
+    std::unique_ptr<Program> program;
+    bool valid;                // segments/program came from a successful parse
+    size_t reparsed_bytes;
+
+    void parseAll(const std::string& source);
+    bool reparseSegments(size_t first, size_t last, std::string text);
+
+public:
+    // Parses `source`; throws like Parser::parse() if it is invalid
+    explicit IncrementalParser(const std::string& source);
+
+    // Applies `edit` to the source and updates the program. If the edited
+    // source does not parse, the error is thrown and program() keeps the
+    // last successfully parsed tree until a later edit fixes the source.
+    void applyEdit(const TextEdit& edit);
+
+    std::string text() const;
+    // A full re-parse replaces the Program, so fetch it again after edits
+    Program* getProgram() const { return program.get(); }
+    // Bytes lexed and parsed by the last edit (or the initial parse)
+    size_t lastReparsedBytes() const { return reparsed_bytes; }
+    size_t segmentCount() const { return segments.size(); }
+};
+
+#endif // INCREMENTAL_PARSER_H
@@ -1,12 +1,16 @@
 #ifndef IR_H
 #define IR_H
 
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
 #include <string>
 #include <vector>
 #include <memory>
 #include <map>
+#include "symbol.h"
 
-enum class IROpcode {
+enum class IROpcode : uint8_t {
     // Arithmetic
     ADD, SUB, MUL, DIV, MOD,
     // Comparison
@@ -22,44 +26,227 @@ enum class IROpcode {
     // Move
     MOVE,
     // Constant
-    CONST
+    CONST,
+    // Placeholder left by IRFunction::eraseInstruction
+    NOP
 };
 
+// Instruction operand: a small tagged value, so passes classify operands
+// by kind instead of by spelling. Temporaries and labels are numbered per
+// function; variables, function names and the text of string constants
+// and array element references are interned symbols.
+class Operand {
+public:
+    enum Kind : uint8_t { NONE, TEMP, IMM, VAR, LABEL };
+
+    Kind kind;
+    int32_t value;   // temp/label number, immediate, or symbol id
+
+    Operand() : kind(NONE), value(0) {}
+    Operand(Kind kind, int32_t value) : kind(kind), value(value) {}
+
+    static Operand temp(int number) { return Operand(TEMP, number); }
+    static Operand imm(int value) { return Operand(IMM, value); }
+    static Operand var(Symbol symbol) {
+        return symbol.empty() ? Operand() : Operand(VAR, static_cast<int32_t>(symbol.getId()));
+    }
+    static Operand label(int number) { return Operand(LABEL, number); }
+
+    bool empty() const { return kind == NONE; }
+    bool isTemp() const { return kind == TEMP; }
+    bool isImm() const { return kind == IMM; }
+    bool isVar() const { return kind == VAR; }
+    bool isLabel() const { return kind == LABEL; }
+    Symbol symbol() const { return kind == VAR ? Symbol::fromId(static_cast<uint32_t>(value)) : Symbol(); }
+    // Spelling used in IR dumps and assembly: "t3", "42", "x", "L1"
+    std::string toString() const;
+
+    bool operator==(Operand other) const { return kind == other.kind && value == other.value; }
+    bool operator!=(Operand other) const { return !(*this == other); }
+    bool operator<(Operand other) const {
+        return kind != other.kind ? kind < other.kind : value < other.value;
+    }
+};
+
+std::ostream& operator<<(std::ostream& os, Operand operand);
+
+namespace std {
+template <>
+struct hash<Operand> {
+    size_t operator()(Operand operand) const noexcept {
+        return hash<uint64_t>()((static_cast<uint64_t>(operand.kind) << 32) |
+                                static_cast<uint32_t>(operand.value));
+    }
+};
+}  // namespace std
+
+// Fixed-size, trivially copyable instruction
 class IRInstruction {
 public:
     IROpcode opcode;
-    std::string result;
-    std::string arg1;
-    std::string arg2;
+    Operand result;
+    Operand arg1;
+    Operand arg2;
     
-    IRInstruction(IROpcode opcode, const std::string& result = "",
-                  const std::string& arg1 = "", const std::string& arg2 = "");
+    IRInstruction(IROpcode opcode, Operand result = Operand(),
+                  Operand arg1 = Operand(), Operand arg2 = Operand());
     std::string toString() const;
     static std::string opcodeToString(IROpcode opcode);
+
+    // Calls f on every operand slot the instruction reads: arg1 and arg2,
+    // and result for RETURN and PARAM. Labels, callee and variable names
+    // are included; callers usually only care about temporaries.
+    template <typename F>
+    void forEachUse(F&& f) {
+        if (opcode == IROpcode::RETURN || opcode == IROpcode::PARAM) {
+            f(result);
+        }
+        f(arg1);
+        f(arg2);
+    }
+    template <typename F>
+    void forEachUse(F&& f) const {
+        if (opcode == IROpcode::RETURN || opcode == IROpcode::PARAM) {
+            f(result);
+        }
+        f(arg1);
+        f(arg2);
+    }
+};
+
+// SSA join: result takes incoming[i] when control arrives from the
+// block's preds[i]. Phis only exist between mem2reg and out-of-SSA.
+struct Phi {
+    Operand result;
+    std::vector<Operand> incoming;
+};
+
+// Straight-line run of instructions, entered only at the top (through an
+// optional leading LABEL) and left only at the bottom: by its terminator
+// (JUMP, BRANCH or RETURN) or by falling through to the next block.
+class BasicBlock {
+public:
+    Operand label;                              // empty if the block has no LABEL
+    std::vector<Phi> phis;                      // evaluated on entry, before the LABEL
+    std::vector<IRInstruction> instructions;    // including the LABEL and terminator
+    std::vector<int> preds;                     // block indices, no duplicates
+    std::vector<int> succs;
+
+    // The last instruction if it transfers control, otherwise null
+    const IRInstruction* terminator() const;
+};
+
+// Position of a temporary's definition: an instruction of a block, or a
+// phi when phi is set. block is NONE for a temporary without a definition
+// and MULTIPLE for one defined more than once (IR that is not in SSA form).
+struct DefSite {
+    enum : int { NONE = -1, MULTIPLE = -2 };
+    int block = NONE;
+    int index = 0;
+    bool phi = false;
+
+    bool unique() const { return block >= 0; }
 };
 
+// Operand slot that reads a temporary: in an instruction, slot 0 is
+// result (RETURN and PARAM), 1 is arg1 and 2 is arg2; in a phi, slot is
+// the incoming index.
+struct UseSite {
+    int block;
+    int index;
+    int slot;
+    bool phi;
+};
+
+class DominatorTree;
+class LoopInfo;
+
 class IRFunction {
 public:
-    std::string name;
+    Symbol name;
     std::string return_type;
-    std::vector<std::string> params;
+    std::vector<Symbol> params;
     std::vector<IRInstruction> instructions;
     int temp_counter;
     int label_counter;
-    
-    IRFunction(const std::string& name, const std::string& return_type);
-    std::string newTemp();
-    std::string newLabel();
+
+    // Control flow graph (src/ir/cfg.cpp). buildCFG() moves the body from
+    // instructions into blocks, in layout order; block 0 is the entry and
+    // has no predecessors. Passes edit blocks in place and keep preds and
+    // succs (and phi operands) current with addEdge/removeEdge;
+    // linearize() moves the body back into instructions and requires
+    // that no phis are left.
+    std::vector<BasicBlock> blocks;
+
+    IRFunction(Symbol name, const std::string& return_type);
+    Operand newTemp();
+    Operand newLabel();
     void addInstruction(const IRInstruction& instr);
+    // Instructions in the body, whether linear or in blocks
+    size_t instructionCount() const;
+
+    void buildCFG();
+    void linearize();
+    bool hasCFG() const { return !blocks.empty(); }
+    // Appends an empty block starting with a fresh label. If the previous
+    // last block fell off the end of the function, it now returns instead.
+    int addBlock();
+    void addEdge(int from, int to);
+    void removeEdge(int from, int to);
+    // Drops blocks that cannot be reached from the entry and renumbers the
+    // rest. Returns true if anything was removed.
+    bool removeUnreachableBlocks();
+
+    // Analyses of the CFG, built on first use and kept until the blocks or
+    // edges change through one of the methods above. A pass that rewires
+    // blocks by hand calls invalidateAnalyses() itself, which also drops
+    // the def-use chains.
+    const DominatorTree& dominatorTree();
+    const LoopInfo& loopInfo();
+    void invalidateAnalyses();
+
+    // Def-use chains over the blocks (src/ir/def_use.cpp): for every
+    // temporary, where it is defined and every operand slot that reads it.
+    // Built by buildDefUse() and kept current by the three edits below, so
+    // passes follow them instead of rescanning the function. Erased code
+    // stays in place, as a NOP or a phi without result, until compact();
+    // any other change to the blocks or edges drops the chains.
+    void buildDefUse();
+    bool hasDefUse() const { return def_use_built; }
+    void dropDefUse();
+    DefSite def(Operand temp) const;
+    const std::vector<UseSite>& uses(Operand temp) const;
+    Operand& operandAt(const UseSite& use);
+    // Rewrites every use of the temporary from to read to instead
+    void replaceAllUsesWith(Operand from, Operand to);
+    void eraseInstruction(int block, int index);
+    void erasePhi(int block, int index);
+    // Removes erased instructions and phis; drops the chains
+    void compact();
+
+private:
+    std::shared_ptr<const DominatorTree> dominator_tree;
+    std::shared_ptr<const LoopInfo> loop_info;
+
+    bool def_use_built = false;
+    std::vector<DefSite> value_defs;                // indexed by temp number
+    std::vector<std::vector<UseSite>> value_uses;
+
+    std::vector<UseSite>& useList(Operand temp);
+    void removeUse(Operand temp, const UseSite& use);
 };
 
 class IRModule {
 public:
     std::vector<IRFunction> functions;
-    std::map<std::string, int> global_vars;
+    std::map<Symbol, int> global_vars;
     
     void addFunction(const IRFunction& func);
     std::string toString() const;
+    // Indices of the functions from the most instructions to the fewest:
+    // handed to a thread pool in this order, a large function does not
+    // start last and finish long after the rest
+    std::vector<size_t> largestFirst() const;
 };
 
 #endif // IR_H
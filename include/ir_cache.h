@@ -0,0 +1,54 @@
+#ifndef IR_CACHE_H
+#define IR_CACHE_H
+
+#include "ir.h"
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+// On-disk cache of optimized IR, one file per compilation. Entries are
+// keyed by a hash of the source bytes, the flags that affect the IR and
+// the compiler version, and hold a compact binary form of the IRModule:
+// every distinct symbol once, then instructions as an opcode byte and
+// three operands (a kind byte and a number, variables by symbol index).
+// A hit lets the driver go straight to code generation.
+//
+// Each entry also records the source bytes and flags, so a hash collision
+// is detected and treated as a miss, as are unreadable or stale entries.
+// Entries are written to a temporary file and renamed into place, so
+// concurrent compilers sharing a directory never see partial files, and
+// one IRCache may be used from several threads.
+class IRCache {
+private:
+    std::string directory;
+    std::atomic<size_t> hits;
+    std::atomic<size_t> misses;
+
+    std::string path(uint64_t key) const;
+
+public:
+    // Bump when the serialized form changes; older entries become misses
+    static constexpr uint32_t FORMAT_VERSION = 4;
+    // Checksum of the sources that decide the IR a source compiles to
+    // (lexer through optimizer), computed by the build; entries written by
+    // a compiler built from other sources become misses
+    static const uint32_t COMPILER_VERSION;
+
+    // The directory is created on first store
+    explicit IRCache(std::string directory);
+
+    static uint64_t hash(std::string_view source, std::string_view flags);
+
+    // Fills `module` and returns true on a hit
+    bool load(std::string_view source, std::string_view flags, IRModule& module);
+    // Returns false if the entry could not be written
+    bool store(std::string_view source, std::string_view flags, const IRModule& module);
+
+    size_t hitCount() const { return hits; }
+    size_t missCount() const { return misses; }
+    void printStats(std::ostream& os) const;
+};
+
+#endif // IR_CACHE_H
@@ -3,18 +3,18 @@
 
 #include "ast.h"
 #include "ir.h"
-#include <map>
 #include <string>
+#include <unordered_map>
 
 class IRGenerator : public ASTVisitor {
 private:
     IRModule module;
     IRFunction* current_function;
-    std::map<std::string, std::string> symbol_table;
-    std::string last_result;
-    std::string break_label;
-    std::string continue_label;
-    
+    std::unordered_map<Symbol, Symbol> symbol_table;
+    Operand last_result;
+    Operand break_label;
+    Operand continue_label;
+
 public:
     IRGenerator();
     IRModule generate(Program* program);
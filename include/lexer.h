@@ -2,33 +2,59 @@
 #define LEXER_H
 
 #include "token.h"
+#include "token_stream.h"
+#include "token_buffer.h"
+#include <deque>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 
-class Lexer {
+// The Lexer does not copy its input: tokens view the source buffer
+// directly, so the buffer (and the Lexer, which owns the decoded text of
+// escaped string literals) must outlive every token it produces.
+//
+// As a TokenSource the Lexer feeds the Parser one token at a time, so the
+// full token sequence never needs to be materialized.
+class Lexer : public TokenSource {
 private:
-    std::string source;
+    std::string_view source;
     size_t position;
     int line;
     int column;
     char current_char;
+    size_t token_count;
+    bool eof_reached;
     
-    std::unordered_map<std::string, TokenType> keywords;
+    std::deque<std::string> literal_storage;
     
     void advance();
+    void advanceTo(size_t target);
     char peek(int offset = 1) const;
     void skipWhitespace();
     void skipComment();
+    // Skips whitespace and comments up to the next token (or the end)
+    void skipTrivia();
+    // Restarts lexing at `start`, which must be a '\n' (the first character
+    // of line `start_line`) or the start of the input
+    void seek(size_t start, int start_line);
+    Token makeToken(TokenType type, size_t start, int start_line, int start_column) const;
     Token number();
     Token identifier();
     Token charLiteral();
     Token stringLiteral();
     
 public:
-    Lexer(const std::string& source);
+    Lexer(std::string_view source);
     Token getNextToken();
+    Token next() override;
     std::vector<Token> tokenize();
+    // Lexes the whole input into packed storage; the result only needs the
+    // source buffer, not the Lexer, to stay alive
+    TokenBuffer tokenizePacked();
+    // Tokens handed out by next(), including the first END_OF_FILE
+    size_t tokenCount() const { return token_count; }
+    
+    friend class ParallelLexer;
 };
 
 #endif // LEXER_H
@@ -0,0 +1,41 @@
+#ifndef LOOPS_H
+#define LOOPS_H
+
+#include <vector>
+#include "dominators.h"
+#include "ir.h"
+
+// A natural loop: the header and every block that can reach one of its
+// back edges (an edge into the header from a block the header dominates)
+// without passing through the header. Loops with the same header are one
+// loop; cycles without a dominating header (irreducible flow) are not
+// loops here.
+struct Loop {
+    int header;
+    int parent;                 // enclosing loop, -1 for an outermost loop
+    int depth;                  // 1 for an outermost loop
+    std::vector<int> blocks;    // ascending, header included
+    std::vector<int> latches;   // sources of the back edges
+    std::vector<int> children;  // directly nested loops
+};
+
+// Loop nesting forest of an IRFunction's CFG. Loops are numbered so that
+// an enclosing loop comes before the loops nested in it.
+class LoopInfo {
+private:
+    std::vector<Loop> loop_list;
+    std::vector<int> innermost;     // per block, -1 outside every loop
+
+public:
+    LoopInfo(const IRFunction& func, const DominatorTree& dominators);
+
+    const std::vector<Loop>& loops() const { return loop_list; }
+    const Loop& loop(int index) const { return loop_list[static_cast<size_t>(index)]; }
+    // Innermost loop containing the block, -1 if none
+    int loopFor(int block) const { return innermost[static_cast<size_t>(block)]; }
+    // Number of loops containing the block
+    int depth(int block) const;
+    bool contains(int loop, int block) const;
+};
+
+#endif // LOOPS_H
@@ -2,32 +2,55 @@
 #define OPTIMIZER_H
 
 #include "ir.h"
+#include "pass_manager.h"
+#include "thread_pool.h"
 #include <vector>
 #include <map>
 #include <set>
 
 class Optimizer {
 private:
-    // Constant folding
-    bool constantFolding(IRFunction& func);
+    PassManager passes;
+    CompileStats* stats;
     
-    // Dead code elimination
-    bool deadCodeElimination(IRFunction& func);
+    // CFG, passes and out-of-SSA on one function; safe to run on several
+    // functions at once
+    void runPipeline(IRFunction& func);
+    
+    // Unreachable block removal
+    static bool removeUnreachableCode(IRFunction& func);
+    
+    // mem2reg: scalar locals to SSA values (undone before returning)
+    static bool promoteToSSA(IRFunction& func);
+    
+    // Sparse passes, visiting one instruction or phi at a time
+    
+    // Constant folding
+    static bool constantFolding(IRFunction& func, const WorkItem& item, Worklist& worklist);
     
     // Constant propagation
-    bool constantPropagation(IRFunction& func);
+    static bool constantPropagation(IRFunction& func, const WorkItem& item, Worklist& worklist);
+    
+    // Dead code elimination
+    static bool deadCodeElimination(IRFunction& func, const WorkItem& item, Worklist& worklist);
     
     // Common subexpression elimination
     bool commonSubexpressionElimination(IRFunction& func);
     
     // Helper methods
-    bool isConstant(const std::string& var, const std::map<std::string, int>& constants);
-    int getConstantValue(const std::string& var, const std::map<std::string, int>& constants);
+    bool isConstant(Operand var, const std::map<Operand, int>& constants);
+    int getConstantValue(Operand var, const std::map<Operand, int>& constants);
     
 public:
     Optimizer();
     IRModule optimize(const IRModule& module);
+    // Optimizes the functions concurrently on the pool; the result is the
+    // same as optimize(module)
+    IRModule optimize(const IRModule& module, ThreadPool& pool);
     IRFunction optimizeFunction(const IRFunction& func);
+    const PassManager& passManager() const { return passes; }
+    // Per-pass rows for -ftime-report, nested under the caller's phase
+    void setStats(CompileStats* stats);
 };
 
 #endif // OPTIMIZER_H
@@ -0,0 +1,60 @@
+#ifndef PARALLEL_LEXER_H
+#define PARALLEL_LEXER_H
+
+#include "token.h"
+#include "thread_pool.h"
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Tokenizes a large input on several threads. The source is cut into
+// chunks at newlines and each chunk is lexed speculatively on a worker
+// without knowing whether its first line continues a block comment (or a
+// string) from the previous chunk. The chunks are then stitched in order:
+// wherever the real token stream lines up with a speculation it is reused
+// with its line numbers shifted, and anything else is re-lexed.
+//
+// The result is identical to Lexer(source).tokenize(), including errors.
+// As with Lexer, tokens view the source and may refer to decoded string
+// literals owned by the ParallelLexer, so both must outlive the tokens.
+class ParallelLexer {
+private:
+    // Tokens lexed from a position assumed to be outside any token
+    struct Speculation {
+        size_t start;
+        std::vector<Token> tokens;
+        size_t resume;          // first token start at or past the chunk end
+        size_t merge_index;     // joins the code speculation here, or npos
+        bool failed;            // lexing threw; tokens stop at the error
+        std::deque<std::string> literals;
+    };
+
+    struct Chunk {
+        size_t begin;
+        size_t end;
+        size_t newlines;        // '\n' bytes in (begin, end]
+        Speculation code;       // assumes the chunk starts between tokens
+        Speculation comment;    // assumes it starts inside a block comment
+        bool has_comment_end;
+    };
+
+    std::string_view source;
+    ThreadPool& pool;
+    size_t min_chunk;
+    std::vector<std::deque<std::string>> literal_storage;
+
+    std::vector<Chunk> split() const;
+    void speculate(Chunk& chunk) const;
+    void lexChunk(Chunk& chunk, size_t from, const Speculation* converge, Speculation& out) const;
+    bool splice(Chunk& chunk, Speculation& spec, int line_offset, size_t& resume, std::vector<Token>& tokens);
+
+public:
+    static constexpr size_t DEFAULT_MIN_CHUNK = 256 * 1024;
+
+    // Inputs shorter than two chunks of `min_chunk` bytes are lexed serially
+    ParallelLexer(std::string_view source, ThreadPool& pool, size_t min_chunk = DEFAULT_MIN_CHUNK);
+    std::vector<Token> tokenize();
+};
+
+#endif // PARALLEL_LEXER_H
@@ -0,0 +1,38 @@
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+#include "ast.h"
+#include "thread_pool.h"
+#include "token_buffer.h"
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Parses the function bodies of a translation unit on several threads.
+// A pre-pass over the token types matches braces to find the token range
+// of every top-level '{' ... '}', which can only be a function body. The
+// declarations are then parsed serially with each body replaced by an
+// empty block, while the bodies themselves are parsed concurrently in
+// batches, each into its own arena, and attached to their FunctionDefs
+// in source order. The batch arenas are adopted by the Program.
+//
+// The result is the same tree Parser(tokens).parse() builds. If anything
+// fails to parse, the input is parsed again serially so that the error
+// reported is the one the serial Parser finds first.
+class ParallelParser {
+private:
+    const TokenBuffer& tokens;
+    ThreadPool& pool;
+    // Token index of each body's '{' and its matching '}'
+    std::vector<std::pair<size_t, size_t>> bodies;
+
+    bool findBodies();
+    std::unique_ptr<Program> parseSkeleton();
+    void parseBodies(Program& program, std::vector<FunctionDef*>& functions);
+
+public:
+    ParallelParser(const TokenBuffer& tokens, ThreadPool& pool);
+    std::unique_ptr<Program> parse();
+};
+
+#endif // PARALLEL_PARSER_H
@@ -2,10 +2,13 @@
 #define PARSER_H
 
 #include "token.h"
+#include "token_stream.h"
+#include "token_buffer.h"
 #include "ast.h"
 #include <vector>
 #include <memory>
 #include <stdexcept>
+#include <string>
 
 class ParseError : public std::runtime_error {
 public:
@@ -14,38 +17,86 @@ public:
 
 class Parser {
 private:
-    std::vector<Token> tokens;
-    size_t current;
+    std::unique_ptr<TokenSource> owned_source;
+    TokenStream tokens;
+    Arena* arena;  // of the Program being built
+    Arena recycled;  // blocks for the next Program (see reuseArena)
+    // Errors recovered from so far; null while errors are thrown instead
+    std::vector<std::string>* errors;
+    const char* last_error_at;  // token the last recorded error was reported at
     
-    Token currentToken() const;
-    Token peek(int offset = 1) const;
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return arena->make<T>(std::forward<Args>(args)...);
+    }
+    std::string_view typeName(std::string_view base, int pointer_level);
+    
+    const Token& currentToken();
+    const Token& peek(int offset = 1);
     void advance();
     bool match(TokenType type);
-    bool match(const std::vector<TokenType>& types);
-    void expect(TokenType type, const std::string& message);
+    void expect(TokenType type, const char* message);
+    void recordError(const ParseError& error, const char* start);
+    void synchronize(bool top_level);
     
     std::unique_ptr<Program> parseProgram();
-    std::unique_ptr<FunctionDef> parseFunctionDef();
-    std::unique_ptr<VarDecl> parseVarDecl();
-    std::unique_ptr<VarDecl> parseConstDecl();
-    std::unique_ptr<Statement> parseStatement();
-    std::unique_ptr<Block> parseBlock();
-    std::unique_ptr<IfStmt> parseIfStmt();
-    std::unique_ptr<WhileStmt> parseWhileStmt();
-    std::unique_ptr<ReturnStmt> parseReturnStmt();
-    std::unique_ptr<Expression> parseExpression();
-    std::unique_ptr<Expression> parseLogicalOr();
-    std::unique_ptr<Expression> parseLogicalAnd();
-    std::unique_ptr<Expression> parseEquality();
-    std::unique_ptr<Expression> parseRelational();
-    std::unique_ptr<Expression> parseAdditive();
-    std::unique_ptr<Expression> parseMultiplicative();
-    std::unique_ptr<Expression> parseUnary();
-    std::unique_ptr<Expression> parsePrimary();
+    ASTNode* parseTopLevel();
+    FunctionDef* parseFunctionDef();
+    VarDecl* parseVarDecl();
+    VarDecl* parseConstDecl();
+    Statement* parseStatement();
+    Block* parseBlock();
+    IfStmt* parseIfStmt();
+    WhileStmt* parseWhileStmt();
+    ReturnStmt* parseReturnStmt();
+    Expression* parseExpression();
+    void reduce();
+    
+    // Operator waiting for its operands while an expression is parsed.
+    // Openers (GROUP, CALL, SUBSCRIPT) have power 0, so no binary operator
+    // reduces across them.
+    struct PendingOp {
+        enum Kind : uint8_t { BINARY, PREFIX, GROUP, CALL, SUBSCRIPT } kind;
+        uint8_t power;
+        BinaryOp binary;
+        UnaryOp unary;
+        CallExpr* call;   // CALL: receives the arguments
+        Symbol name;      // SUBSCRIPT: the array
+    };
+    // Reused across expressions so parsing one does not allocate
+    std::vector<PendingOp> operators;
+    std::vector<Expression*> operands;
     
 public:
+    // Pulls tokens from `source` (typically a Lexer) as parsing proceeds
+    Parser(TokenSource& source);
+    // Parses a materialized token vector, which must outlive the Parser
     Parser(const std::vector<Token>& tokens);
+    // Parses packed tokens, which must outlive the Parser
+    Parser(const TokenBuffer& tokens);
     std::unique_ptr<Program> parse();
+    // Parses the whole input even if it has errors: each error is appended
+    // to `errors`, the parser skips ahead to the next statement or
+    // declaration (panic mode), and the Program holds what did parse
+    std::unique_ptr<Program> parse(std::vector<std::string>& errors);
+    // The next Program is built in the blocks of `arena` (reset first)
+    // instead of fresh ones, so a driver compiling many units keeps
+    // reusing the memory of the finished ones
+    void reuseArena(Arena&& arena);
+    // The blocks given to reuseArena when no Program took them over, as
+    // after parse() threw; an empty arena otherwise
+    Arena reclaimArena() { return std::move(recycled); }
+    
+    // Top-level declarations one at a time, for callers that need to know
+    // where each one starts (see IncrementalParser)
+    bool atEnd();
+    const Token& nextToken() { return currentToken(); }
+    // Nodes are allocated in `program`'s arena; the caller adds the result
+    // to program.declarations
+    ASTNode* parseDeclaration(Program& program);
+    // A function body, from its '{' through the matching '}', allocated in
+    // `arena` (see ParallelParser)
+    Block* parseBody(Arena& arena);
 };
 
 #endif // PARSER_H
@@ -0,0 +1,110 @@
+#ifndef PASS_MANAGER_H
+#define PASS_MANAGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ir.h"
+#include "stats.h"
+
+// Analyses cached on IRFunction that a pass can require or preserve
+enum Analysis : unsigned {
+    ANALYSIS_NONE = 0,
+    ANALYSIS_DOMINATORS = 1u << 0,
+    ANALYSIS_LOOPS = 1u << 1,
+    ANALYSIS_DEF_USE = 1u << 2,
+    ANALYSIS_ALL = ANALYSIS_DOMINATORS | ANALYSIS_LOOPS | ANALYSIS_DEF_USE
+};
+
+// An instruction or a phi of a CFG block
+struct WorkItem {
+    int block;
+    int index;
+    bool phi;
+};
+
+// Items waiting to be revisited by the sparse passes, each queued at most
+// once at a time. Positions stay valid because sparse passes only erase
+// code (leaving NOPs) and never insert it.
+class Worklist {
+private:
+    std::vector<WorkItem> stack;
+    std::vector<size_t> phi_base;       // per block, offset of its first phi
+    std::vector<size_t> instr_base;     // per block, offset of its first instruction
+    std::vector<uint8_t> queued;
+
+    size_t slot(const WorkItem& item) const;
+
+public:
+    explicit Worklist(const IRFunction& func);
+
+    void push(const WorkItem& item);
+    // Queues the definition of a temporary, if it has a single one
+    void pushDef(const IRFunction& func, Operand temp);
+    // Queues every instruction and phi that reads a temporary
+    void pushUsers(const IRFunction& func, Operand temp);
+    bool empty() const { return stack.empty(); }
+    WorkItem pop();
+};
+
+// A whole-function pass returns true if it changed the function. A sparse
+// pass looks at one item and returns true if it changed it, queueing any
+// other items the change may affect. Sparse passes are plain functions:
+// they run once per item, where an indirect std::function call shows.
+using FunctionPassFn = std::function<bool(IRFunction&)>;
+using SparsePassFn = bool (*)(IRFunction&, const WorkItem&, Worklist&);
+
+struct Pass {
+    std::string name;
+    unsigned required;      // built before the pass runs
+    unsigned preserved;     // still valid after the pass changed something
+    FunctionPassFn run;     // exactly one of run and visit is set
+    SparsePassFn visit;
+};
+
+// Runs passes over a function in the order they were added. A run of
+// consecutive sparse passes forms one phase: one sweep offers every phi
+// and instruction, in layout order, to the phase's passes in turn, and
+// after each item whatever the passes queued is drained the same way.
+// Work is therefore proportional to the code plus the changes, instead
+// of a fixed number of rescans. Erased code is compacted away when the
+// phase ends.
+//
+// With statistics on, each pass gets a row (instructions in and out) and
+// so does each sparse phase; the sparse passes' own rows count items
+// visited and changed, and are timed by wall clock only, since reading
+// the thread CPU clock per item would cost more than most visits.
+class PassManager {
+private:
+    std::vector<Pass> passes;
+    std::atomic<size_t> visit_count;
+    CompileStats* stats;
+    int stats_depth;
+
+    static void prepare(IRFunction& func, unsigned required);
+    static void invalidate(IRFunction& func, unsigned preserved);
+    void runSparse(IRFunction& func, size_t first, size_t last);
+
+public:
+    PassManager();
+
+    void addPass(const std::string& name, unsigned required, unsigned preserved, FunctionPassFn run);
+    void addSparsePass(const std::string& name, unsigned required, unsigned preserved, SparsePassFn visit);
+    const std::vector<Pass>& getPasses() const { return passes; }
+
+    // Rows are recorded at the given nesting depth; null turns them off
+    void setStats(CompileStats* stats, int depth) {
+        this->stats = stats;
+        stats_depth = depth;
+    }
+
+    // Requires a CFG. Functions may be run concurrently once the passes
+    // are set up.
+    void run(IRFunction& func);
+    // Items offered to sparse passes so far
+    size_t visitCount() const { return visit_count; }
+};
+
+#endif // PASS_MANAGER_H
@@ -0,0 +1,36 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <cstddef>
+
+// Byte-class scanning primitives behind the Lexer's fast paths. Each scan
+// returns a pointer to the first byte in [p, end) that stops it, or end.
+// A NUL byte always stops a scan, matching the Lexer's end-of-input check.
+//
+// On x86-64 the scans classify 16 (SSE2) or 32 (AVX2) bytes at a time; the
+// widest implementation supported by the running CPU is selected on first
+// use, with a portable scalar fallback.
+namespace scan {
+
+enum class Impl { SCALAR, SSE2, AVX2 };
+
+// Whitespace as classified by std::isspace in the "C" locale
+const char* skipWhitespace(const char* p, const char* end);
+// Identifier continuation characters: [A-Za-z0-9_]
+const char* skipIdentChars(const char* p, const char* end);
+const char* skipDigits(const char* p, const char* end);
+// End of a // comment: the next '\n'
+const char* findLineEnd(const char* p, const char* end);
+// End of a /* comment: the '*' of the next "*/"
+const char* findBlockCommentEnd(const char* p, const char* end);
+// Number of '\n' bytes in [p, end); *last_newline is set to the final one
+size_t countNewlines(const char* p, const char* end, const char** last_newline);
+
+Impl activeImpl();
+// Forces an implementation (for testing); returns false if the CPU lacks it
+bool setImpl(Impl impl);
+const char* implName(Impl impl);
+
+} // namespace scan
+
+#endif // SCAN_H
@@ -0,0 +1,32 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <string>
+#include <string_view>
+
+// Read-only view of a source file. Regular files are memory-mapped so the
+// lexer can hand out tokens that point straight into the mapped bytes;
+// anything that cannot be mapped (pipes, empty files) is read into memory.
+class SourceBuffer {
+private:
+    const char* data;
+    size_t size;
+    bool mapped;
+    std::string fallback;
+
+    void release();
+
+public:
+    explicit SourceBuffer(const std::string& filename);
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    SourceBuffer(SourceBuffer&& other) noexcept;
+    SourceBuffer& operator=(SourceBuffer&& other) noexcept;
+
+    std::string_view view() const { return std::string_view(data, size); }
+    bool isMapped() const { return mapped; }
+};
+
+#endif // SOURCE_BUFFER_H
@@ -0,0 +1,23 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "ir.h"
+
+// mem2reg: promotes scalar locals to SSA values. A variable qualifies when
+// it is ALLOCed once, as a scalar (size 4), before any other reference,
+// is never indexed, and otherwise only appears as the target of STORE or
+// the source of LOAD, so nothing can reach its slot by name. Its STOREs become plain values, its LOADs are
+// replaced by the reaching value, and phis are placed at the iterated
+// dominance frontier of its definitions (only for variables read in a
+// block before being written there). Reads of an undefined variable yield
+// 0. Requires a CFG with every block reachable; returns true if any
+// variable was promoted. Uses the function's cached dominator tree.
+bool promoteMemoryToRegisters(IRFunction& func);
+
+// Out of SSA: replaces each phi by MOVEs at the end of its predecessors.
+// Edges from a BRANCH get a block of their own for the copies, and the
+// copies on one edge are ordered (with a temporary to break cycles) so
+// they behave as if performed simultaneously.
+void destroySSA(IRFunction& func);
+
+#endif // SSA_H
@@ -0,0 +1,73 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "trace.h"
+
+// Time and size statistics behind -ftime-report and -stats. Code that
+// wants to be measured takes a CompileStats pointer and wraps its work in
+// a ScopedPhase; with a null pointer (reporting off) that is one branch
+// per phase and nothing else. Recording is thread-safe.
+class CompileStats {
+public:
+    // One row per phase name and nesting depth, accumulated over every
+    // time it ran (e.g. a pass, once per function)
+    struct Phase {
+        std::string name;
+        int depth;              // 0 for a top-level phase
+        size_t runs;
+        double wall_ms;
+        double cpu_ms;          // CPU time of the thread running the phase
+        size_t items_in;        // usually instructions; see the call site
+        size_t items_out;
+        long peak_rss_kb;       // process high-water mark when it last ended
+    };
+
+    // Finds or adds the row; rows keep the order they were first begun in,
+    // so a phase lists ahead of the phases nested in it
+    size_t begin(const std::string& name, int depth);
+    void end(size_t row, double wall_ms, double cpu_ms, size_t items_in, size_t items_out);
+    std::vector<Phase> phases() const;
+
+    void printTable(std::ostream& os) const;
+    void printJSON(std::ostream& os) const;
+
+    static double threadCPUTimeMs();
+    static long peakRSSKb();
+
+private:
+    mutable std::mutex mutex;
+    std::vector<Phase> rows;
+};
+
+// Also a span in the -ftrace timeline when tracing is on
+class ScopedPhase {
+private:
+    TraceScope trace;
+    CompileStats* stats;
+    size_t row;
+    size_t items_in;
+    size_t items_out;
+    std::chrono::steady_clock::time_point wall_start;
+    double cpu_start;
+
+public:
+    ScopedPhase(CompileStats* stats, const std::string& name, int depth = 0, size_t items_in = 0);
+    ~ScopedPhase();
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    // Whether phases are being measured at all; callers skip computing
+    // item counts otherwise
+    static bool enabled(CompileStats* stats) { return stats || Tracer::active(); }
+
+    void setItemsIn(size_t count) { items_in = count; }
+    void setItemsOut(size_t count) { items_out = count; }
+};
+
+#endif // STATS_H
@@ -0,0 +1,96 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include "arena.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Process-wide table of interned strings. Each distinct string is copied
+// once into an arena and assigned a dense 32-bit id; id 0 is the empty
+// string. Interning is thread-safe (the table is sharded by hash to keep
+// lock contention low) and looking up the text of an id never locks.
+class StringInterner {
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+    static constexpr size_t BLOCK_BITS = 12;
+    static constexpr size_t BLOCK_SIZE = size_t(1) << BLOCK_BITS;
+    static constexpr size_t MAX_BLOCKS = size_t(1) << 16;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string_view, uint32_t> ids;
+        Arena chars;
+    };
+
+    Shard shards[SHARD_COUNT];
+    std::atomic<uint32_t> next_id;
+    // id -> text, in fixed-size blocks that never move once published
+    std::atomic<std::string_view*> blocks[MAX_BLOCKS];
+
+    void publish(uint32_t id, std::string_view text);
+
+    StringInterner();
+    ~StringInterner();
+
+public:
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    static StringInterner& global();
+
+    uint32_t intern(std::string_view text);
+    std::string_view lookup(uint32_t id) const {
+        return blocks[id >> BLOCK_BITS].load(std::memory_order_acquire)[id & (BLOCK_SIZE - 1)];
+    }
+    size_t size() const { return next_id.load(std::memory_order_relaxed); }
+};
+
+// Handle to an interned string. Symbols compare and hash by id, so names
+// can be used as map keys without touching their characters.
+class Symbol {
+private:
+    uint32_t id;
+
+public:
+    Symbol() : id(0) {}
+    Symbol(std::string_view text) : id(StringInterner::global().intern(text)) {}
+    Symbol(const std::string& text) : Symbol(std::string_view(text)) {}
+    Symbol(const char* text) : Symbol(std::string_view(text)) {}
+
+    static Symbol fromId(uint32_t id) {
+        Symbol symbol;
+        symbol.id = id;
+        return symbol;
+    }
+
+    uint32_t getId() const { return id; }
+    bool empty() const { return id == 0; }
+    std::string_view str() const { return StringInterner::global().lookup(id); }
+    std::string toString() const { return std::string(str()); }
+
+    bool operator==(Symbol other) const { return id == other.id; }
+    bool operator!=(Symbol other) const { return id != other.id; }
+    // Orders by id (i.e. first-interned first), not alphabetically
+    bool operator<(Symbol other) const { return id < other.id; }
+};
+
+inline std::ostream& operator<<(std::ostream& os, Symbol symbol) {
+    return os << symbol.str();
+}
+
+namespace std {
+template <>
+struct hash<Symbol> {
+    size_t operator()(Symbol symbol) const noexcept {
+        return symbol.getId();
+    }
+};
+} // namespace std
+
+#endif // SYMBOL_H
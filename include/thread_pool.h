@@ -0,0 +1,52 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel phases of the compiler.
+// Work is expressed as parallelFor over an index range; the calling thread
+// takes part, so a pool of size 1 simply runs everything inline.
+class ThreadPool {
+private:
+    struct Job {
+        const std::function<void(size_t)>* task;
+        size_t count;
+        size_t next;       // next index to hand out
+        size_t finished;   // indices completed
+        size_t active;     // workers currently holding this job
+        std::exception_ptr error;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    Job* current;
+    bool stopping;
+
+    void workerLoop();
+    void runJob(Job& job, std::unique_lock<std::mutex>& lock);
+
+public:
+    // `threads` counts the calling thread; 0 means one per hardware thread
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Runs task(i) for every i in [0, count) and returns once all calls have
+    // finished. If any call throws, the first exception is rethrown here.
+    // Calls made from inside a task run inline on that thread.
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+};
+
+#endif // THREAD_POOL_H
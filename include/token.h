@@ -2,6 +2,8 @@
 #define TOKEN_H
 
 #include <string>
+#include <string_view>
+#include "symbol.h"
 
 enum class TokenType {
     // Keywords
@@ -32,18 +34,62 @@ enum class TokenType {
     UNKNOWN
 };
 
+// Keyword classification over the fixed keyword set: dispatch on length
+// and first character, then compare the remaining bytes. Needs no table,
+// no hashing and no allocation, and is usable in constant expressions.
+constexpr TokenType lookupKeyword(std::string_view text) {
+    switch (text.size()) {
+        case 2:
+            if (text == "if") return TokenType::IF;
+            break;
+        case 3:
+            if (text == "int") return TokenType::INT;
+            break;
+        case 4:
+            switch (text[0]) {
+                case 'v': if (text == "void") return TokenType::VOID; break;
+                case 'c': if (text == "char") return TokenType::CHAR; break;
+                case 'e': if (text == "else") return TokenType::ELSE; break;
+            }
+            break;
+        case 5:
+            switch (text[0]) {
+                case 'c': if (text == "const") return TokenType::CONST; break;
+                case 'w': if (text == "while") return TokenType::WHILE; break;
+                case 'b': if (text == "break") return TokenType::BREAK; break;
+            }
+            break;
+        case 6:
+            if (text == "return") return TokenType::RETURN;
+            break;
+        case 7:
+            if (text == "typedef") return TokenType::TYPEDEF;
+            break;
+        case 8:
+            if (text == "continue") return TokenType::CONTINUE;
+            break;
+    }
+    return TokenType::IDENT;
+}
+
+// Tokens do not own their text: lexeme views the source buffer, and
+// string_value views either the source (no escapes) or storage owned by
+// the Lexer that produced the token. Identifiers are also interned, so
+// later phases can use `symbol` instead of the text.
 class Token {
 public:
     TokenType type;
-    std::string lexeme;
+    std::string_view lexeme;
     int line;
     int column;
     int value;  // For integer literals
-    std::string string_value;  // For string literals
+    std::string_view string_value;  // For string literals
+    Symbol symbol;  // For identifiers
     
-    Token(TokenType type, const std::string& lexeme, int line, int column);
-    Token(TokenType type, const std::string& lexeme, int line, int column, int value);
-    Token(TokenType type, const std::string& lexeme, int line, int column, const std::string& str_val);
+    Token();
+    Token(TokenType type, std::string_view lexeme, int line, int column);
+    Token(TokenType type, std::string_view lexeme, int line, int column, int value);
+    Token(TokenType type, std::string_view lexeme, int line, int column, std::string_view str_val);
     
     std::string toString() const;
     static std::string tokenTypeToString(TokenType type);
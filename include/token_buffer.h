@@ -0,0 +1,86 @@
+#ifndef TOKEN_BUFFER_H
+#define TOKEN_BUFFER_H
+
+#include "token.h"
+#include "token_stream.h"
+#include "arena.h"
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Maps source offsets to the Lexer's line/column numbering. Built from a
+// single newline scan, and only when a position is actually needed.
+class LineTable {
+private:
+    // Offset at which each line starts. Like the Lexer, a '\n' counts as
+    // the first character of the line it begins (except at offset 0).
+    std::vector<uint32_t> starts;
+    size_t source_size;
+
+    uint32_t clamp(uint32_t offset) const;
+
+public:
+    explicit LineTable(std::string_view source);
+    int line(uint32_t offset) const;
+    int column(uint32_t offset) const;
+};
+
+// Packed token storage: parallel arrays of type, source offset, length and
+// one literal slot per token, with line/column derived on demand from a
+// LineTable. The literal slot holds the value of INT/CHAR literals, the
+// symbol id of identifiers, or an index into string_values for string
+// literals. Tokens are materialized as Token views only when read.
+class TokenBuffer {
+private:
+    std::string_view source;
+    std::vector<uint8_t> types;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<uint32_t> literals;
+    std::vector<std::string_view> string_values;
+    Arena decoded;  // escaped string literals
+    mutable std::unique_ptr<LineTable> line_table;
+
+    const LineTable& lines() const;
+
+public:
+    explicit TokenBuffer(std::string_view source);
+
+    void append(const Token& token);
+    void reserve(size_t count);
+
+    size_t size() const { return types.size(); }
+    std::string_view getSource() const { return source; }
+    TokenType type(size_t index) const { return static_cast<TokenType>(types[index]); }
+    uint32_t offset(size_t index) const { return offsets[index]; }
+    std::string_view lexeme(size_t index) const { return source.substr(offsets[index], lengths[index]); }
+    int value(size_t index) const;
+    std::string_view stringValue(size_t index) const;
+    Symbol symbol(size_t index) const;
+
+    // Positions are computed lazily, for diagnostics
+    int line(size_t index) const { return lines().line(offsets[index]); }
+    int column(size_t index) const { return lines().column(offsets[index]); }
+    int lineAt(uint32_t source_offset) const { return lines().line(source_offset); }
+
+    // Full Token for `index`; with_position also fills in line/column
+    Token token(size_t index, bool with_position = true) const;
+    // Bytes held by the packed arrays (excluding the source itself)
+    size_t memoryUsage() const;
+};
+
+// Feeds a TokenBuffer to the Parser. Tokens are handed out without
+// line/column; the Parser asks line() when it reports an error.
+class TokenBufferSource : public TokenSource {
+private:
+    const TokenBuffer& buffer;
+    size_t index;
+
+public:
+    explicit TokenBufferSource(const TokenBuffer& buffer, size_t start = 0);
+    Token next() override;
+    int line(const Token& token) const override;
+};
+
+#endif // TOKEN_BUFFER_H
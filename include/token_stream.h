@@ -0,0 +1,57 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include "token.h"
+#include <vector>
+
+// Pull-based producer of tokens. Once the input is exhausted next() keeps
+// returning END_OF_FILE.
+class TokenSource {
+public:
+    virtual ~TokenSource() = default;
+    virtual Token next() = 0;
+    // Line of a token this source produced, for diagnostics. Sources that
+    // do not track positions eagerly override this to compute it.
+    virtual int line(const Token& token) const { return token.line; }
+};
+
+// Adapts an already materialized token vector (which must end with
+// END_OF_FILE and outlive the source) to the pull interface.
+class VectorTokenSource : public TokenSource {
+private:
+    const std::vector<Token>& tokens;
+    size_t index;
+
+public:
+    explicit VectorTokenSource(const std::vector<Token>& tokens);
+    Token next() override;
+};
+
+// Lookahead window over a TokenSource. Tokens are pulled on demand into a
+// small ring buffer, so memory is bounded by the deepest peek rather than
+// by the size of the input. The window grows only if a caller peeks past
+// its current capacity.
+class TokenStream {
+private:
+    TokenSource& source;
+    std::vector<Token> ring;   // capacity is always a power of two
+    size_t head;               // ring index of the current token
+    size_t count;              // tokens buffered starting at head
+    bool at_eof;               // END_OF_FILE has been pulled
+
+    void fill(size_t needed);
+    void grow();
+
+public:
+    static constexpr size_t INITIAL_LOOKAHEAD = 8;
+
+    explicit TokenStream(TokenSource& source);
+
+    // Token `offset` positions ahead of the current one; END_OF_FILE past the end
+    const Token& peek(size_t offset = 0);
+    // Moves to the next token; the stream never moves past END_OF_FILE
+    void advance();
+    int line(const Token& token) const { return source.line(token); }
+};
+
+#endif // TOKEN_STREAM_H
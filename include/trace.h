@@ -0,0 +1,75 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Timeline of the compilation for -ftrace=<file>, written as Chrome
+// trace-event JSON (chrome://tracing, Perfetto). Spans are opened with a
+// TraceScope; they only record anything while a Tracer is installed, so
+// otherwise each one costs a relaxed atomic load. Spans on one thread nest
+// by time; each carries the small sequential id of the thread it ran on.
+class Tracer {
+public:
+    struct Event {
+        std::string name;
+        std::string args;       // JSON object members, without the braces
+        double start_us;
+        double duration_us;
+        int thread;
+    };
+
+    Tracer();
+
+    // Makes the tracer the process-wide one; null uninstalls it
+    static void install(Tracer* tracer) { current.store(tracer, std::memory_order_release); }
+    static Tracer* active() { return current.load(std::memory_order_relaxed); }
+    // 1 for the first thread that asks, 2 for the next, ...
+    static int threadId();
+
+    double nowUs() const;
+    void record(Event event);
+    // Names the calling thread in the trace viewer
+    void nameThread(const std::string& name);
+    void write(std::ostream& os) const;
+
+private:
+    static std::atomic<Tracer*> current;
+
+    std::chrono::steady_clock::time_point start;
+    mutable std::mutex mutex;
+    std::vector<Event> events;
+    std::vector<std::pair<int, std::string>> thread_names;
+};
+
+class TraceScope {
+private:
+    Tracer* tracer;
+    std::string name;
+    std::string args;
+    double start_us;
+
+public:
+    explicit TraceScope(const char* name);
+    ~TraceScope();
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    // Arguments shown with the span; callers check active() before
+    // building expensive values
+    bool active() const { return tracer != nullptr; }
+    void arg(const char* key, const std::string& value);
+    void arg(const char* key, long long value);
+    // Closes the span early; the destructor then does nothing
+    void end();
+};
+
+// Writes text as a JSON string literal, quotes included
+void writeJSONString(std::ostream& os, const std::string& text);
+
+#endif // TRACE_H
@@ -1,10 +1,16 @@
 #include "codegen.h"
+#include "trace.h"
 #include <sstream>
 #include <iostream>
 
 CodeGenerator::CodeGenerator() : stack_offset(0) {}
 
 std::string CodeGenerator::generate(const IRModule& module) {
+    ThreadPool inline_pool(1);
+    return generate(module, inline_pool);
+}
+
+std::string CodeGenerator::generate(const IRModule& module, ThreadPool& pool) {
     std::ostringstream result;
     
     // Assembly header
@@ -12,14 +18,46 @@ std::string CodeGenerator::generate(const IRModule& module) {
     result << ".global main\n\n";
     
     // Generate each function
-    for (const auto& func : module.functions) {
-        result << generateFunction(func);
+    if (pool.size() == 1) {
+        for (const auto& func : module.functions) {
+            result << generateFunction(func);
+        }
+    } else {
+        std::vector<std::string> parts(module.functions.size());
+        std::vector<size_t> order = module.largestFirst();
+        pool.parallelFor(order.size(), [&](size_t i) {
+            CodeGenerator codegen;
+            parts[order[i]] = codegen.generateFunction(module.functions[order[i]]);
+        });
+        for (const std::string& part : parts) {
+            result << part;
+        }
     }
     
     return result.str();
 }
 
+// Loads an operand into a register: immediates directly, values with a
+// stack slot from the frame, and other names (globals) RIP-relative
+void CodeGenerator::loadOperand(std::ostringstream& out, Operand operand, const char* reg) {
+    auto slot = var_offsets.find(operand);
+    if (operand.isImm()) {
+        out << "    movq $" << operand.value << ", " << reg << "\n";
+    } else if (slot != var_offsets.end()) {
+        out << "    movq -" << slot->second << "(%rbp), " << reg << "\n";
+    } else if (operand.isVar()) {
+        out << "    movq " << operand << "(%rip), " << reg << "\n";
+    } else {
+        out << "    movq -" << var_offsets[operand] << "(%rbp), " << reg << "\n";
+    }
+}
+
 std::string CodeGenerator::generateFunction(const IRFunction& func) {
+    TraceScope trace("generateFunction");
+    if (trace.active()) {
+        trace.arg("function", func.name.toString());
+        trace.arg("instructions", static_cast<long long>(func.instructions.size()));
+    }
     std::ostringstream result;
     var_offsets.clear();
     stack_offset = 0;
@@ -36,6 +74,14 @@ std::string CodeGenerator::generateFunction(const IRFunction& func) {
         result << "    subq $" << local_space << ", %rsp\n";
     }
     
+    // Values assigned by MOVE (out of SSA) may be read before the first
+    // MOVE in layout order, so their slots are fixed up front
+    for (const auto& instr : func.instructions) {
+        if (instr.opcode == IROpcode::MOVE && var_offsets.find(instr.result) == var_offsets.end()) {
+            var_offsets[instr.result] = (stack_offset += 8);
+        }
+    }
+    
     // Generate instructions
     for (const auto& instr : func.instructions) {
         result << "    # " << instr.toString() << "\n";
@@ -48,21 +94,13 @@ std::string CodeGenerator::generateFunction(const IRFunction& func) {
                 break;
                 
             case IROpcode::LOAD:
-                if (var_offsets.find(instr.arg1) != var_offsets.end()) {
-                    result << "    movq -" << var_offsets[instr.arg1] << "(%rbp), %rax\n";
-                } else {
-                    result << "    movq " << instr.arg1 << "(%rip), %rax\n";
-                }
+                loadOperand(result, instr.arg1, "%rax");
                 result << "    movq %rax, -" << (stack_offset += 8) << "(%rbp)\n";
                 var_offsets[instr.result] = stack_offset;
                 break;
                 
             case IROpcode::STORE:
-                if (var_offsets.find(instr.arg1) != var_offsets.end()) {
-                    result << "    movq -" << var_offsets[instr.arg1] << "(%rbp), %rax\n";
-                } else {
-                    result << "    movq $" << instr.arg1 << ", %rax\n";
-                }
+                loadOperand(result, instr.arg1, "%rax");
                 if (var_offsets.find(instr.result) == var_offsets.end()) {
                     var_offsets[instr.result] = (stack_offset += 8);
                 }
@@ -70,33 +108,33 @@ std::string CodeGenerator::generateFunction(const IRFunction& func) {
                 break;
                 
             case IROpcode::ADD:
-                result << "    movq -" << var_offsets[instr.arg1] << "(%rbp), %rax\n";
-                result << "    movq -" << var_offsets[instr.arg2] << "(%rbp), %rbx\n";
+                loadOperand(result, instr.arg1, "%rax");
+                loadOperand(result, instr.arg2, "%rbx");
                 result << "    addq %rbx, %rax\n";
                 result << "    movq %rax, -" << (stack_offset += 8) << "(%rbp)\n";
                 var_offsets[instr.result] = stack_offset;
                 break;
                 
             case IROpcode::SUB:
-                result << "    movq -" << var_offsets[instr.arg1] << "(%rbp), %rax\n";
-                result << "    movq -" << var_offsets[instr.arg2] << "(%rbp), %rbx\n";
+                loadOperand(result, instr.arg1, "%rax");
+                loadOperand(result, instr.arg2, "%rbx");
                 result << "    subq %rbx, %rax\n";
                 result << "    movq %rax, -" << (stack_offset += 8) << "(%rbp)\n";
                 var_offsets[instr.result] = stack_offset;
                 break;
                 
             case IROpcode::MUL:
-                result << "    movq -" << var_offsets[instr.arg1] << "(%rbp), %rax\n";
-                result << "    movq -" << var_offsets[instr.arg2] << "(%rbp), %rbx\n";
+                loadOperand(result, instr.arg1, "%rax");
+                loadOperand(result, instr.arg2, "%rbx");
                 result << "    imulq %rbx, %rax\n";
                 result << "    movq %rax, -" << (stack_offset += 8) << "(%rbp)\n";
                 var_offsets[instr.result] = stack_offset;
                 break;
                 
             case IROpcode::DIV:
-                result << "    movq -" << var_offsets[instr.arg1] << "(%rbp), %rax\n";
+                loadOperand(result, instr.arg1, "%rax");
                 result << "    cqto\n";
-                result << "    movq -" << var_offsets[instr.arg2] << "(%rbp), %rbx\n";
+                loadOperand(result, instr.arg2, "%rbx");
                 result << "    idivq %rbx\n";
                 result << "    movq %rax, -" << (stack_offset += 8) << "(%rbp)\n";
                 var_offsets[instr.result] = stack_offset;
@@ -111,15 +149,15 @@ std::string CodeGenerator::generateFunction(const IRFunction& func) {
                 break;
                 
             case IROpcode::BRANCH:
-                result << "    movq -" << var_offsets[instr.arg1] << "(%rbp), %rax\n";
+                loadOperand(result, instr.arg1, "%rax");
                 result << "    cmpq $0, %rax\n";
                 result << "    jne " << instr.result << "\n";
                 result << "    jmp " << instr.arg2 << "\n";
                 break;
                 
             case IROpcode::RETURN:
-                if (!instr.result.empty() && var_offsets.find(instr.result) != var_offsets.end()) {
-                    result << "    movq -" << var_offsets[instr.result] << "(%rbp), %rax\n";
+                if (!instr.result.empty()) {
+                    loadOperand(result, instr.result, "%rax");
                 }
                 result << "    movq %rbp, %rsp\n";
                 result << "    popq %rbp\n";
@@ -135,9 +173,14 @@ std::string CodeGenerator::generateFunction(const IRFunction& func) {
                 }
                 break;
                 
+            case IROpcode::MOVE:
+                loadOperand(result, instr.arg1, "%rax");
+                result << "    movq %rax, -" << var_offsets[instr.result] << "(%rbp)\n";
+                break;
+                
             case IROpcode::ALLOC:
                 // Allocate space
-                var_offsets[instr.result] = (stack_offset += std::stoi(instr.arg1));
+                var_offsets[instr.result] = (stack_offset += instr.arg1.value);
                 break;
                 
             default:
@@ -0,0 +1,172 @@
+#include "batch_compiler.h"
+#include "codegen.h"
+#include "ir_generator.h"
+#include "lexer.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "source_buffer.h"
+#include "trace.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+BatchCompiler::BatchCompiler(ThreadPool& pool, bool optimize)
+    : pool(pool), optimize(optimize), cache(nullptr), stats(nullptr) {}
+
+size_t BatchCompiler::compile(std::vector<Unit>& units) {
+    // Units sharing an output file (a/foo.sy and b/foo.sy under one -d)
+    // would overwrite each other in whatever order they finish; neither
+    // is compiled
+    std::unordered_map<std::string, size_t> writers;
+    for (size_t i = 0; i < units.size(); i++) {
+        std::string output = std::filesystem::path(units[i].output).lexically_normal().string();
+        auto writer = writers.emplace(output, i);
+        if (!writer.second) {
+            Unit& first = units[writer.first->second];
+            first.errors.push_back("output " + first.output + " is also written for " + units[i].input);
+            units[i].errors.push_back("output " + units[i].output + " is also written for " + first.input);
+        }
+    }
+
+    // Largest first, so a big unit does not start last
+    std::vector<uintmax_t> sizes(units.size());
+    std::vector<size_t> order;
+    for (size_t i = 0; i < units.size(); i++) {
+        std::error_code error;
+        sizes[i] = std::filesystem::file_size(units[i].input, error);
+        if (units[i].errors.empty()) {
+            order.push_back(i);
+        }
+    }
+    if (pool.size() > 1) {
+        std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) {
+            return sizes[a] > sizes[b];
+        });
+    }
+    pool.parallelFor(order.size(), [&](size_t i) { compileUnit(units[order[i]]); });
+
+    size_t failed = 0;
+    for (const Unit& unit : units) {
+        failed += unit.ok ? 0 : 1;
+    }
+    return failed;
+}
+
+void BatchCompiler::compileUnit(Unit& unit) {
+    TraceScope trace("compileUnit");
+    trace.arg("file", unit.input);
+    try {
+        SourceBuffer source(unit.input);
+        std::string assembly;
+        if (!compileSource(source.view(), assembly, unit.errors)) {
+            return;
+        }
+        std::ofstream file(unit.output);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not write to file: " + unit.output);
+        }
+        file << assembly;
+        unit.ok = true;
+    } catch (const std::exception& e) {
+        unit.errors.push_back(e.what());
+    }
+}
+
+bool BatchCompiler::compileSource(std::string_view source, std::string& assembly,
+                                  std::vector<std::string>& errors) {
+    // Flags that change the cached IR
+    const std::string ir_flags = optimize ? "-O1" : "-O0";
+    IRModule module;
+    if (!cache || !cache->load(source, ir_flags, module)) {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        parser.reuseArena(takeArena());
+        std::unique_ptr<Program> ast;
+        try {
+            {
+                ScopedPhase phase(stats, "Lexing + parsing", 0, source.size());
+                ast = parser.parse(errors);
+                phase.setItemsOut(lexer.tokenCount());
+            }
+            if (errors.empty()) {
+                ScopedPhase phase(stats, "IR generation", 0, lexer.tokenCount());
+                IRGenerator ir_gen;
+                module = ir_gen.generate(ast.get());
+            }
+        } catch (...) {
+            // Failed units give their arena back too
+            returnArena(ast ? std::move(ast->arena) : parser.reclaimArena());
+            throw;
+        }
+        // The IR holds no pointers into the tree
+        returnArena(std::move(ast->arena));
+        if (!errors.empty()) {
+            return false;
+        }
+        if (optimize) {
+            ScopedPhase phase(stats, "Optimization");
+            Optimizer optimizer;
+            optimizer.setStats(stats);
+            module = optimizer.optimize(module);
+        }
+        if (cache) {
+            ScopedPhase phase(stats, "IR cache store");
+            cache->store(source, ir_flags, module);
+        }
+    }
+
+    ScopedPhase phase(stats, "Code generation");
+    CodeGenerator codegen;
+    assembly = codegen.generate(module);
+    phase.setItemsOut(assembly.size());
+    return true;
+}
+
+Arena BatchCompiler::takeArena() {
+    std::lock_guard<std::mutex> lock(arenas_mutex);
+    if (arenas.empty()) {
+        return Arena();
+    }
+    Arena arena = std::move(arenas.back());
+    arenas.pop_back();
+    return arena;
+}
+
+size_t BatchCompiler::spareArenaCount() const {
+    std::lock_guard<std::mutex> lock(arenas_mutex);
+    return arenas.size();
+}
+
+void BatchCompiler::returnArena(Arena arena) {
+    std::lock_guard<std::mutex> lock(arenas_mutex);
+    arenas.push_back(std::move(arena));
+}
+
+std::string BatchCompiler::outputPath(const std::string& input, const std::string& directory) {
+    std::filesystem::path path(input);
+    path.replace_extension(".s");
+    if (!directory.empty()) {
+        path = std::filesystem::path(directory) / path.filename();
+    }
+    return path.string();
+}
+
+std::vector<std::string> BatchCompiler::readFileList(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file list: " + path);
+    }
+    std::vector<std::string> inputs;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        size_t last = line.find_last_not_of(" \t\r");
+        inputs.push_back(line.substr(first, last - first + 1));
+    }
+    return inputs;
+}
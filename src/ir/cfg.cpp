@@ -0,0 +1,200 @@
+#include "ir.h"
+#include <algorithm>
+#include <stdexcept>
+#include "dominators.h"
+#include "loops.h"
+
+static bool isTerminator(IROpcode opcode) {
+    return opcode == IROpcode::JUMP || opcode == IROpcode::BRANCH || opcode == IROpcode::RETURN;
+}
+
+const IRInstruction* BasicBlock::terminator() const {
+    if (instructions.empty() || !isTerminator(instructions.back().opcode)) {
+        return nullptr;
+    }
+    return &instructions.back();
+}
+
+void IRFunction::buildCFG() {
+    invalidateAnalyses();
+    blocks.clear();
+    // Nothing can branch to an unlabeled first instruction, so only a
+    // leading LABEL needs an empty entry block in front of it
+    blocks.emplace_back();
+    std::vector<int> label_blocks(static_cast<size_t>(label_counter), -1);
+    for (const IRInstruction& instr : instructions) {
+        if (instr.opcode == IROpcode::LABEL || blocks.back().terminator()) {
+            blocks.emplace_back();
+        }
+        BasicBlock& block = blocks.back();
+        if (instr.opcode == IROpcode::LABEL) {
+            block.label = instr.result;
+            if (instr.result.value >= 0 && instr.result.value < label_counter) {
+                label_blocks[static_cast<size_t>(instr.result.value)] = static_cast<int>(blocks.size() - 1);
+            }
+        }
+        block.instructions.push_back(instr);
+    }
+    instructions.clear();
+
+    auto target = [&](Operand label) {
+        if (!label.isLabel() || label.value < 0 || label.value >= label_counter ||
+            label_blocks[static_cast<size_t>(label.value)] < 0) {
+            throw std::runtime_error("Branch to undefined label " + label.toString() +
+                                     " in function " + name.toString());
+        }
+        return label_blocks[static_cast<size_t>(label.value)];
+    };
+    for (size_t i = 0; i < blocks.size(); i++) {
+        int from = static_cast<int>(i);
+        const IRInstruction* last = blocks[i].terminator();
+        if (!last) {
+            if (i + 1 < blocks.size()) {
+                addEdge(from, from + 1);
+            }
+        } else if (last->opcode == IROpcode::JUMP) {
+            addEdge(from, target(last->result));
+        } else if (last->opcode == IROpcode::BRANCH) {
+            addEdge(from, target(last->result));
+            addEdge(from, target(last->arg2));
+        }
+    }
+}
+
+void IRFunction::linearize() {
+    invalidateAnalyses();
+    instructions.clear();
+    for (BasicBlock& block : blocks) {
+        if (!block.phis.empty()) {
+            throw std::logic_error("Phis left in function " + name.toString());
+        }
+        for (const IRInstruction& instr : block.instructions) {
+            if (instr.opcode != IROpcode::NOP) {
+                instructions.push_back(instr);
+            }
+        }
+    }
+    blocks.clear();
+}
+
+int IRFunction::addBlock() {
+    invalidateAnalyses();
+    if (!blocks.empty()) {
+        BasicBlock& last = blocks.back();
+        if (!last.terminator() && last.succs.empty()) {
+            last.instructions.emplace_back(IROpcode::RETURN);
+        }
+    }
+    blocks.emplace_back();
+    BasicBlock& block = blocks.back();
+    block.label = newLabel();
+    block.instructions.emplace_back(IROpcode::LABEL, block.label);
+    return static_cast<int>(blocks.size() - 1);
+}
+
+// A new edge brings an operand slot in each phi of the target, to be
+// filled in by the caller
+void IRFunction::addEdge(int from, int to) {
+    std::vector<int>& succs = blocks[static_cast<size_t>(from)].succs;
+    if (std::find(succs.begin(), succs.end(), to) == succs.end()) {
+        invalidateAnalyses();
+        succs.push_back(to);
+        BasicBlock& target = blocks[static_cast<size_t>(to)];
+        target.preds.push_back(from);
+        for (Phi& phi : target.phis) {
+            phi.incoming.emplace_back();
+        }
+    }
+}
+
+void IRFunction::removeEdge(int from, int to) {
+    invalidateAnalyses();
+    std::vector<int>& succs = blocks[static_cast<size_t>(from)].succs;
+    succs.erase(std::remove(succs.begin(), succs.end(), to), succs.end());
+    BasicBlock& target = blocks[static_cast<size_t>(to)];
+    auto pred = std::find(target.preds.begin(), target.preds.end(), from);
+    if (pred != target.preds.end()) {
+        size_t index = static_cast<size_t>(pred - target.preds.begin());
+        target.preds.erase(pred);
+        for (Phi& phi : target.phis) {
+            phi.incoming.erase(phi.incoming.begin() + static_cast<std::ptrdiff_t>(index));
+        }
+    }
+}
+
+bool IRFunction::removeUnreachableBlocks() {
+    std::vector<bool> reachable(blocks.size(), false);
+    std::vector<int> worklist = {0};
+    reachable[0] = true;
+    while (!worklist.empty()) {
+        int block = worklist.back();
+        worklist.pop_back();
+        for (int succ : blocks[static_cast<size_t>(block)].succs) {
+            if (!reachable[static_cast<size_t>(succ)]) {
+                reachable[static_cast<size_t>(succ)] = true;
+                worklist.push_back(succ);
+            }
+        }
+    }
+    if (std::find(reachable.begin(), reachable.end(), false) == reachable.end()) {
+        return false;
+    }
+    invalidateAnalyses();
+
+    // A reachable block's predecessors may be unreachable, never its
+    // successors, and nothing reachable falls through into a removed block
+    std::vector<int> renumbered(blocks.size(), -1);
+    size_t kept = 0;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (reachable[i]) {
+            renumbered[i] = static_cast<int>(kept);
+            if (kept != i) {
+                blocks[kept] = std::move(blocks[i]);
+            }
+            kept++;
+        }
+    }
+    blocks.resize(kept);
+    for (BasicBlock& block : blocks) {
+        size_t kept_preds = 0;
+        for (size_t i = 0; i < block.preds.size(); i++) {
+            int pred = renumbered[static_cast<size_t>(block.preds[i])];
+            if (pred < 0) {
+                continue;
+            }
+            block.preds[kept_preds] = pred;
+            for (Phi& phi : block.phis) {
+                phi.incoming[kept_preds] = phi.incoming[i];
+            }
+            kept_preds++;
+        }
+        block.preds.resize(kept_preds);
+        for (Phi& phi : block.phis) {
+            phi.incoming.resize(kept_preds);
+        }
+        for (int& succ : block.succs) {
+            succ = renumbered[static_cast<size_t>(succ)];
+        }
+    }
+    return true;
+}
+
+const DominatorTree& IRFunction::dominatorTree() {
+    if (!dominator_tree) {
+        dominator_tree = std::make_shared<const DominatorTree>(*this);
+    }
+    return *dominator_tree;
+}
+
+const LoopInfo& IRFunction::loopInfo() {
+    if (!loop_info) {
+        loop_info = std::make_shared<const LoopInfo>(*this, dominatorTree());
+    }
+    return *loop_info;
+}
+
+void IRFunction::invalidateAnalyses() {
+    dominator_tree.reset();
+    loop_info.reset();
+    dropDefUse();
+}
@@ -0,0 +1,172 @@
+#include "ir.h"
+#include <algorithm>
+
+// Calls f(slot, operand) on every operand slot of the instruction that
+// reads a temporary, numbered as in UseSite
+template <typename F>
+static void forEachTempUse(IRInstruction& instr, F&& f) {
+    if ((instr.opcode == IROpcode::RETURN || instr.opcode == IROpcode::PARAM) && instr.result.isTemp()) {
+        f(0, instr.result);
+    }
+    if (instr.arg1.isTemp()) {
+        f(1, instr.arg1);
+    }
+    if (instr.arg2.isTemp()) {
+        f(2, instr.arg2);
+    }
+}
+
+static bool definesTemp(const IRInstruction& instr) {
+    return instr.result.isTemp() && instr.opcode != IROpcode::RETURN && instr.opcode != IROpcode::PARAM;
+}
+
+void IRFunction::buildDefUse() {
+    value_defs.assign(static_cast<size_t>(temp_counter), DefSite());
+    value_uses.assign(static_cast<size_t>(temp_counter), {});
+    def_use_built = true;
+
+    auto define = [&](Operand temp, DefSite site) {
+        useList(temp);
+        DefSite& def = value_defs[static_cast<size_t>(temp.value)];
+        def = def.block == DefSite::NONE ? site : DefSite{DefSite::MULTIPLE, 0, false};
+    };
+    for (size_t b = 0; b < blocks.size(); b++) {
+        int block = static_cast<int>(b);
+        std::vector<Phi>& phis = blocks[b].phis;
+        for (size_t p = 0; p < phis.size(); p++) {
+            int index = static_cast<int>(p);
+            if (phis[p].result.isTemp()) {
+                define(phis[p].result, {block, index, true});
+            }
+            for (size_t slot = 0; slot < phis[p].incoming.size(); slot++) {
+                if (phis[p].incoming[slot].isTemp()) {
+                    useList(phis[p].incoming[slot]).push_back({block, index, static_cast<int>(slot), true});
+                }
+            }
+        }
+        std::vector<IRInstruction>& code = blocks[b].instructions;
+        for (size_t i = 0; i < code.size(); i++) {
+            int index = static_cast<int>(i);
+            if (definesTemp(code[i])) {
+                define(code[i].result, {block, index, false});
+            }
+            forEachTempUse(code[i], [&](int slot, Operand operand) {
+                useList(operand).push_back({block, index, slot, false});
+            });
+        }
+    }
+    // Hand-built IR may number temporaries without newTemp(); keep fresh
+    // ones from colliding with them
+    temp_counter = std::max(temp_counter, static_cast<int>(value_uses.size()));
+}
+
+void IRFunction::dropDefUse() {
+    if (def_use_built) {
+        def_use_built = false;
+        value_defs.clear();
+        value_uses.clear();
+    }
+}
+
+DefSite IRFunction::def(Operand temp) const {
+    size_t number = static_cast<size_t>(temp.value);
+    return temp.isTemp() && number < value_defs.size() ? value_defs[number] : DefSite();
+}
+
+const std::vector<UseSite>& IRFunction::uses(Operand temp) const {
+    static const std::vector<UseSite> none;
+    size_t number = static_cast<size_t>(temp.value);
+    return temp.isTemp() && number < value_uses.size() ? value_uses[number] : none;
+}
+
+// Temporaries beyond temp_counter (made by newTemp() after the chains
+// were built, or numbered by hand) get their entries on first use
+std::vector<UseSite>& IRFunction::useList(Operand temp) {
+    size_t number = static_cast<size_t>(temp.value);
+    if (number >= value_uses.size()) {
+        value_uses.resize(number + 1);
+        value_defs.resize(number + 1);
+    }
+    return value_uses[number];
+}
+
+void IRFunction::removeUse(Operand temp, const UseSite& use) {
+    std::vector<UseSite>& list = useList(temp);
+    auto found = std::find_if(list.begin(), list.end(), [&](const UseSite& other) {
+        return other.block == use.block && other.index == use.index &&
+               other.slot == use.slot && other.phi == use.phi;
+    });
+    if (found != list.end()) {
+        *found = list.back();
+        list.pop_back();
+    }
+}
+
+Operand& IRFunction::operandAt(const UseSite& use) {
+    BasicBlock& block = blocks[static_cast<size_t>(use.block)];
+    if (use.phi) {
+        return block.phis[static_cast<size_t>(use.index)].incoming[static_cast<size_t>(use.slot)];
+    }
+    IRInstruction& instr = block.instructions[static_cast<size_t>(use.index)];
+    return use.slot == 0 ? instr.result : use.slot == 1 ? instr.arg1 : instr.arg2;
+}
+
+void IRFunction::replaceAllUsesWith(Operand from, Operand to) {
+    if (from == to || !from.isTemp()) {
+        return;
+    }
+    std::vector<UseSite> moved;
+    moved.swap(useList(from));
+    for (const UseSite& use : moved) {
+        operandAt(use) = to;
+    }
+    if (to.isTemp()) {
+        std::vector<UseSite>& list = useList(to);
+        list.insert(list.end(), moved.begin(), moved.end());
+    }
+}
+
+void IRFunction::eraseInstruction(int block, int index) {
+    IRInstruction& instr = blocks[static_cast<size_t>(block)].instructions[static_cast<size_t>(index)];
+    if (def_use_built) {
+        forEachTempUse(instr, [&](int slot, Operand operand) {
+            removeUse(operand, {block, index, slot, false});
+        });
+        if (definesTemp(instr)) {
+            useList(instr.result);
+            value_defs[static_cast<size_t>(instr.result.value)] = DefSite();
+        }
+    }
+    instr = IRInstruction(IROpcode::NOP);
+}
+
+// The phi keeps one (empty) operand per predecessor so that edge updates
+// before compact() still line up
+void IRFunction::erasePhi(int block, int index) {
+    Phi& phi = blocks[static_cast<size_t>(block)].phis[static_cast<size_t>(index)];
+    for (size_t slot = 0; slot < phi.incoming.size(); slot++) {
+        if (def_use_built && phi.incoming[slot].isTemp()) {
+            removeUse(phi.incoming[slot], {block, index, static_cast<int>(slot), true});
+        }
+        phi.incoming[slot] = Operand();
+    }
+    if (def_use_built && phi.result.isTemp()) {
+        useList(phi.result);
+        value_defs[static_cast<size_t>(phi.result.value)] = DefSite();
+    }
+    phi.result = Operand();
+}
+
+void IRFunction::compact() {
+    dropDefUse();
+    for (BasicBlock& block : blocks) {
+        block.phis.erase(std::remove_if(block.phis.begin(), block.phis.end(),
+                                        [](const Phi& phi) { return phi.result.empty(); }),
+                         block.phis.end());
+        block.instructions.erase(std::remove_if(block.instructions.begin(), block.instructions.end(),
+                                                [](const IRInstruction& instr) {
+                                                    return instr.opcode == IROpcode::NOP;
+                                                }),
+                                 block.instructions.end());
+    }
+}
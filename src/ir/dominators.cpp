@@ -0,0 +1,119 @@
+#include "dominators.h"
+#include <utility>
+
+DominatorTree::DominatorTree(const IRFunction& func) {
+    size_t count = func.blocks.size();
+    idoms.assign(count, -1);
+    child_lists.assign(count, {});
+    frontiers.assign(count, {});
+    rpo_index.assign(count, -1);
+    tree_in.assign(count, -1);
+    tree_out.assign(count, -1);
+    if (count == 0) {
+        return;
+    }
+
+    // Postorder by an explicit-stack DFS, so deep CFGs cannot overflow
+    std::vector<int> postorder;
+    std::vector<bool> visited(count, false);
+    std::vector<std::pair<int, size_t>> stack = {{0, 0}};
+    visited[0] = true;
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+        const std::vector<int>& succs = func.blocks[static_cast<size_t>(block)].succs;
+        if (next < succs.size()) {
+            int succ = succs[next++];
+            if (!visited[static_cast<size_t>(succ)]) {
+                visited[static_cast<size_t>(succ)] = true;
+                stack.emplace_back(succ, 0);
+            }
+        } else {
+            postorder.push_back(block);
+            stack.pop_back();
+        }
+    }
+    rpo.assign(postorder.rbegin(), postorder.rend());
+    for (size_t i = 0; i < rpo.size(); i++) {
+        rpo_index[static_cast<size_t>(rpo[i])] = static_cast<int>(i);
+    }
+
+    auto intersect = [this](int a, int b) {
+        while (a != b) {
+            while (rpo_index[static_cast<size_t>(a)] > rpo_index[static_cast<size_t>(b)]) {
+                a = idoms[static_cast<size_t>(a)];
+            }
+            while (rpo_index[static_cast<size_t>(b)] > rpo_index[static_cast<size_t>(a)]) {
+                b = idoms[static_cast<size_t>(b)];
+            }
+        }
+        return a;
+    };
+    idoms[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < rpo.size(); i++) {
+            int block = rpo[i];
+            int new_idom = -1;
+            for (int pred : func.blocks[static_cast<size_t>(block)].preds) {
+                if (idoms[static_cast<size_t>(pred)] < 0) {
+                    continue;   // unreachable or not processed yet
+                }
+                new_idom = new_idom < 0 ? pred : intersect(pred, new_idom);
+            }
+            if (idoms[static_cast<size_t>(block)] != new_idom) {
+                idoms[static_cast<size_t>(block)] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    for (int block : rpo) {
+        const std::vector<int>& preds = func.blocks[static_cast<size_t>(block)].preds;
+        if (preds.size() < 2) {
+            continue;
+        }
+        for (int pred : preds) {
+            if (!reachable(pred)) {
+                continue;
+            }
+            for (int runner = pred; runner != idoms[static_cast<size_t>(block)];
+                 runner = idoms[static_cast<size_t>(runner)]) {
+                std::vector<int>& frontier = frontiers[static_cast<size_t>(runner)];
+                if (frontier.empty() || frontier.back() != block) {
+                    frontier.push_back(block);
+                }
+            }
+        }
+    }
+    idoms[0] = -1;
+    for (int block : rpo) {
+        if (idoms[static_cast<size_t>(block)] >= 0) {
+            child_lists[static_cast<size_t>(idoms[static_cast<size_t>(block)])].push_back(block);
+        }
+    }
+
+    int clock = 0;
+    std::vector<std::pair<int, size_t>> walk = {{0, 0}};
+    tree_in[0] = clock++;
+    while (!walk.empty()) {
+        auto& [block, next] = walk.back();
+        const std::vector<int>& children = child_lists[static_cast<size_t>(block)];
+        if (next < children.size()) {
+            int child = children[next++];
+            tree_in[static_cast<size_t>(child)] = clock++;
+            walk.emplace_back(child, 0);
+        } else {
+            tree_out[static_cast<size_t>(block)] = clock++;
+            walk.pop_back();
+        }
+    }
+}
+
+bool DominatorTree::dominates(int a, int b) const {
+    if (!reachable(a) || !reachable(b)) {
+        return false;
+    }
+    return tree_in[static_cast<size_t>(a)] <= tree_in[static_cast<size_t>(b)] &&
+           tree_out[static_cast<size_t>(b)] <= tree_out[static_cast<size_t>(a)];
+}
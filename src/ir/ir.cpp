@@ -1,8 +1,33 @@
 #include "ir.h"
+#include <algorithm>
+#include <ostream>
 #include <sstream>
+#include <type_traits>
 
-IRInstruction::IRInstruction(IROpcode opcode, const std::string& result,
-                             const std::string& arg1, const std::string& arg2)
+static_assert(std::is_trivially_copyable<IRInstruction>::value && sizeof(IRInstruction) <= 28,
+              "IRInstruction should stay a small trivially copyable record");
+
+std::string Operand::toString() const {
+    switch (kind) {
+        case TEMP: return "t" + std::to_string(value);
+        case IMM: return std::to_string(value);
+        case VAR: return symbol().toString();
+        case LABEL: return "L" + std::to_string(value);
+        default: return "";
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, Operand operand) {
+    switch (operand.kind) {
+        case Operand::TEMP: return os << 't' << operand.value;
+        case Operand::IMM: return os << operand.value;
+        case Operand::VAR: return os << operand.symbol();
+        case Operand::LABEL: return os << 'L' << operand.value;
+        default: return os;
+    }
+}
+
+IRInstruction::IRInstruction(IROpcode opcode, Operand result, Operand arg1, Operand arg2)
     : opcode(opcode), result(result), arg1(arg1), arg2(arg2) {}
 
 std::string IRInstruction::toString() const {
@@ -66,6 +91,9 @@ std::string IRInstruction::toString() const {
         case IROpcode::CONST:
             oss << result << " = " << arg1;
             break;
+        case IROpcode::NOP:
+            oss << "NOP";
+            break;
     }
     
     return oss.str();
@@ -91,21 +119,29 @@ std::string IRInstruction::opcodeToString(IROpcode opcode) {
     }
 }
 
-IRFunction::IRFunction(const std::string& name, const std::string& return_type)
+IRFunction::IRFunction(Symbol name, const std::string& return_type)
     : name(name), return_type(return_type), temp_counter(0), label_counter(0) {}
 
-std::string IRFunction::newTemp() {
-    return "t" + std::to_string(temp_counter++);
+Operand IRFunction::newTemp() {
+    return Operand::temp(temp_counter++);
 }
 
-std::string IRFunction::newLabel() {
-    return "L" + std::to_string(label_counter++);
+Operand IRFunction::newLabel() {
+    return Operand::label(label_counter++);
 }
 
 void IRFunction::addInstruction(const IRInstruction& instr) {
     instructions.push_back(instr);
 }
 
+size_t IRFunction::instructionCount() const {
+    size_t count = instructions.size();
+    for (const BasicBlock& block : blocks) {
+        count += block.instructions.size();
+    }
+    return count;
+}
+
 void IRModule::addFunction(const IRFunction& func) {
     functions.push_back(func);
 }
@@ -126,3 +162,14 @@ std::string IRModule::toString() const {
     
     return oss.str();
 }
+
+std::vector<size_t> IRModule::largestFirst() const {
+    std::vector<size_t> order(functions.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return functions[a].instructionCount() > functions[b].instructionCount();
+    });
+    return order;
+}
@@ -0,0 +1,298 @@
+#include "ir_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <unistd.h>
+#include <unordered_map>
+
+static constexpr char MAGIC[4] = {'S', 'Y', 'I', 'R'};
+
+// Set by the Makefile; other builds must change the fallback by hand
+// whenever the IR they produce changes
+#ifndef SYSYC_IR_VERSION
+#define SYSYC_IR_VERSION 1
+#endif
+
+const uint32_t IRCache::COMPILER_VERSION = SYSYC_IR_VERSION;
+
+IRCache::IRCache(std::string directory) : directory(std::move(directory)), hits(0), misses(0) {}
+
+// 64-bit multiply-xorshift hash over 8-byte words; not cryptographic, but
+// each entry stores the full source and flags, which load() compares, so a
+// collision is a miss rather than the wrong IR
+uint64_t IRCache::hash(std::string_view source, std::string_view flags) {
+    constexpr uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+    uint64_t h = 0xCBF29CE484222325ULL ^ (source.size() * MULTIPLIER);
+    auto mix = [&h](uint64_t word) {
+        h = (h ^ word) * MULTIPLIER;
+        h ^= h >> 29;
+    };
+    for (std::string_view bytes : {source, flags}) {
+        size_t i = 0;
+        for (; i + 8 <= bytes.size(); i += 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes.data() + i, 8);
+            mix(word);
+        }
+        uint64_t tail = 0;
+        if (i < bytes.size()) {
+            std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+        }
+        mix(tail ^ (static_cast<uint64_t>(bytes.size() - i) << 56));
+    }
+    mix(IRCache::FORMAT_VERSION);
+    mix(IRCache::COMPILER_VERSION);
+    return h;
+}
+
+std::string IRCache::path(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ir", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+namespace {
+
+class Writer {
+public:
+    std::string bytes;
+
+    void u8(uint8_t value) { bytes.push_back(static_cast<char>(value)); }
+    void u32(uint32_t value) { bytes.append(reinterpret_cast<const char*>(&value), 4); }
+    void string(std::string_view text) {
+        u32(static_cast<uint32_t>(text.size()));
+        bytes.append(text.data(), text.size());
+    }
+};
+
+// Bounds-checked reads; any overrun marks the entry as corrupt
+class Reader {
+private:
+    const std::string& bytes;
+    size_t offset;
+
+public:
+    bool ok;
+
+    explicit Reader(const std::string& bytes) : bytes(bytes), offset(0), ok(true) {}
+
+    bool take(void* out, size_t size) {
+        if (!ok || bytes.size() - offset < size) {
+            ok = false;
+            return false;
+        }
+        std::memcpy(out, bytes.data() + offset, size);
+        offset += size;
+        return true;
+    }
+    uint8_t u8() { uint8_t value = 0; take(&value, 1); return value; }
+    uint32_t u32() { uint32_t value = 0; take(&value, 4); return value; }
+    std::string_view string() {
+        uint32_t size = u32();
+        if (!ok || bytes.size() - offset < size) {
+            ok = false;
+            return std::string_view();
+        }
+        std::string_view text(bytes.data() + offset, size);
+        offset += size;
+        return text;
+    }
+    bool atEnd() const { return offset == bytes.size(); }
+};
+
+}  // namespace
+
+bool IRCache::load(std::string_view source, std::string_view flags, IRModule& module) {
+    std::ifstream file(path(hash(source, flags)), std::ios::binary);
+    std::string bytes;
+    if (file) {
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    
+    Reader in(bytes);
+    char magic[4] = {};
+    in.take(magic, 4);
+    bool valid = in.ok && std::memcmp(magic, MAGIC, 4) == 0 && in.u32() == FORMAT_VERSION &&
+                 in.u32() == COMPILER_VERSION &&
+                 in.string() == source && in.string() == flags;
+    
+    IRModule loaded;
+    if (valid) {
+        // Interning in the stored order (the original ids' order) keeps
+        // containers ordered by Symbol, such as global_vars, as they were
+        std::vector<Symbol> symbols(1);
+        uint32_t symbol_count = in.u32();
+        for (uint32_t i = 0; i < symbol_count && in.ok; i++) {
+            symbols.push_back(Symbol(in.string()));
+        }
+        auto symbol = [&](uint32_t index) {
+            if (index >= symbols.size()) {
+                in.ok = false;
+                return Symbol();
+            }
+            return symbols[index];
+        };
+        // Kind byte, then the value; variables refer to the symbol table
+        auto operand = [&]() {
+            uint8_t kind = in.u8();
+            uint32_t value = in.u32();
+            if (kind > Operand::LABEL) {
+                in.ok = false;
+                return Operand();
+            }
+            if (kind == Operand::VAR) {
+                return Operand::var(symbol(value));
+            }
+            return Operand(static_cast<Operand::Kind>(kind), static_cast<int32_t>(value));
+        };
+        
+        uint32_t function_count = in.u32();
+        for (uint32_t f = 0; f < function_count && in.ok; f++) {
+            Symbol name = symbol(in.u32());
+            IRFunction func(name, std::string(in.string()));
+            func.temp_counter = static_cast<int>(in.u32());
+            func.label_counter = static_cast<int>(in.u32());
+            uint32_t param_count = in.u32();
+            for (uint32_t i = 0; i < param_count && in.ok; i++) {
+                func.params.push_back(symbol(in.u32()));
+            }
+            uint32_t instruction_count = in.u32();
+            if (in.ok) {
+                func.instructions.reserve(std::min<size_t>(instruction_count, bytes.size() / 16));
+            }
+            for (uint32_t i = 0; i < instruction_count && in.ok; i++) {
+                uint8_t opcode = in.u8();
+                if (opcode > static_cast<uint8_t>(IROpcode::CONST)) {
+                    in.ok = false;
+                    break;
+                }
+                Operand result = operand();
+                Operand arg1 = operand();
+                Operand arg2 = operand();
+                func.instructions.emplace_back(static_cast<IROpcode>(opcode), result, arg1, arg2);
+            }
+            loaded.functions.push_back(std::move(func));
+        }
+        uint32_t global_count = in.u32();
+        for (uint32_t i = 0; i < global_count && in.ok; i++) {
+            Symbol name = symbol(in.u32());
+            loaded.global_vars[name] = static_cast<int>(in.u32());
+        }
+        valid = in.ok && in.atEnd();
+    }
+    
+    if (!valid) {
+        misses++;
+        return false;
+    }
+    hits++;
+    module = std::move(loaded);
+    return true;
+}
+
+bool IRCache::store(std::string_view source, std::string_view flags, const IRModule& module) {
+    // Every distinct symbol, in id order
+    std::vector<Symbol> symbols;
+    auto collect = [&symbols](Symbol symbol) {
+        if (!symbol.empty()) {
+            symbols.push_back(symbol);
+        }
+    };
+    for (const IRFunction& func : module.functions) {
+        collect(func.name);
+        for (Symbol param : func.params) {
+            collect(param);
+        }
+        for (const IRInstruction& instr : func.instructions) {
+            collect(instr.result.symbol());
+            collect(instr.arg1.symbol());
+            collect(instr.arg2.symbol());
+        }
+    }
+    for (const auto& global : module.global_vars) {
+        collect(global.first);
+    }
+    std::sort(symbols.begin(), symbols.end());
+    symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+    
+    std::unordered_map<Symbol, uint32_t> index;
+    index.reserve(symbols.size());
+    for (size_t i = 0; i < symbols.size(); i++) {
+        index.emplace(symbols[i], static_cast<uint32_t>(i + 1));
+    }
+    auto indexOf = [&index](Symbol symbol) {
+        return symbol.empty() ? 0 : index.at(symbol);
+    };
+    auto writeOperand = [&](Writer& out, Operand operand) {
+        out.u8(operand.kind);
+        out.u32(operand.isVar() ? indexOf(operand.symbol()) : static_cast<uint32_t>(operand.value));
+    };
+    
+    Writer out;
+    out.bytes.append(MAGIC, 4);
+    out.u32(FORMAT_VERSION);
+    out.u32(COMPILER_VERSION);
+    out.string(source);
+    out.string(flags);
+    out.u32(static_cast<uint32_t>(symbols.size()));
+    for (Symbol symbol : symbols) {
+        out.string(symbol.str());
+    }
+    out.u32(static_cast<uint32_t>(module.functions.size()));
+    for (const IRFunction& func : module.functions) {
+        out.u32(indexOf(func.name));
+        out.string(func.return_type);
+        out.u32(static_cast<uint32_t>(func.temp_counter));
+        out.u32(static_cast<uint32_t>(func.label_counter));
+        out.u32(static_cast<uint32_t>(func.params.size()));
+        for (Symbol param : func.params) {
+            out.u32(indexOf(param));
+        }
+        out.u32(static_cast<uint32_t>(func.instructions.size()));
+        for (const IRInstruction& instr : func.instructions) {
+            out.u8(static_cast<uint8_t>(instr.opcode));
+            writeOperand(out, instr.result);
+            writeOperand(out, instr.arg1);
+            writeOperand(out, instr.arg2);
+        }
+    }
+    out.u32(static_cast<uint32_t>(module.global_vars.size()));
+    for (const auto& global : module.global_vars) {
+        out.u32(indexOf(global.first));
+        out.u32(static_cast<uint32_t>(global.second));
+    }
+    
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::string final_path = path(hash(source, flags));
+    // Unique per process and per call, since threads sharing this cache
+    // may store the same source at once
+    static std::atomic<unsigned> store_count{0};
+    std::string temp_path = final_path + ".tmp" + std::to_string(getpid()) + "." +
+                            std::to_string(store_count.fetch_add(1, std::memory_order_relaxed));
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(out.bytes.data(), static_cast<std::streamsize>(out.bytes.size()))) {
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp_path, final_path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+void IRCache::printStats(std::ostream& os) const {
+    size_t hit_count = hits;
+    size_t miss_count = misses;
+    os << "IR cache: " << hit_count << (hit_count == 1 ? " hit, " : " hits, ")
+       << miss_count << (miss_count == 1 ? " miss" : " misses") << " (" << directory << ")\n";
+}
@@ -1,6 +1,15 @@
 #include "ir_generator.h"
 #include <stdexcept>
 
+// Opcode for each BinaryOp except ASSIGN, which becomes a STORE
+static constexpr IROpcode BINARY_OPCODES[] = {
+    IROpcode::ADD, IROpcode::SUB, IROpcode::MUL, IROpcode::DIV, IROpcode::MOD,
+    IROpcode::EQ, IROpcode::NE, IROpcode::LT, IROpcode::LE, IROpcode::GT, IROpcode::GE,
+    IROpcode::AND, IROpcode::OR
+};
+static_assert(sizeof(BINARY_OPCODES) / sizeof(BINARY_OPCODES[0]) == static_cast<size_t>(BinaryOp::ASSIGN),
+              "BINARY_OPCODES must cover every arithmetic, comparison and logical BinaryOp");
+
 IRGenerator::IRGenerator() : current_function(nullptr) {}
 
 IRModule IRGenerator::generate(Program* program) {
@@ -15,7 +24,7 @@ void IRGenerator::visit(Program* node) {
 }
 
 void IRGenerator::visit(FunctionDef* node) {
-    IRFunction func(node->name, node->return_type);
+    IRFunction func(node->name, std::string(node->return_type));
     current_function = &func;
     
     // Add parameters
@@ -42,14 +51,13 @@ void IRGenerator::visit(VarDecl* node) {
     }
     
     // Local variable
-    std::string var_name = node->name;
+    Symbol var_name = node->name;
     
     if (node->is_array) {
-        std::string size_str = std::to_string(node->array_size);
-        current_function->addInstruction(IRInstruction(IROpcode::ALLOC, var_name, size_str));
+        current_function->addInstruction(IRInstruction(IROpcode::ALLOC, Operand::var(var_name), Operand::imm(node->array_size)));
     } else {
         // Allocate space for variable
-        current_function->addInstruction(IRInstruction(IROpcode::ALLOC, var_name, "4"));
+        current_function->addInstruction(IRInstruction(IROpcode::ALLOC, Operand::var(var_name), Operand::imm(4)));
     }
     
     symbol_table[var_name] = var_name;
@@ -57,7 +65,7 @@ void IRGenerator::visit(VarDecl* node) {
     // Initialize if there's an init value
     if (node->init_value) {
         node->init_value->accept(this);
-        current_function->addInstruction(IRInstruction(IROpcode::STORE, var_name, last_result));
+        current_function->addInstruction(IRInstruction(IROpcode::STORE, Operand::var(var_name), last_result));
     }
 }
 
@@ -68,13 +76,13 @@ void IRGenerator::visit(Block* node) {
 }
 
 void IRGenerator::visit(IfStmt* node) {
-    std::string then_label = current_function->newLabel();
-    std::string else_label = current_function->newLabel();
-    std::string end_label = current_function->newLabel();
+    Operand then_label = current_function->newLabel();
+    Operand else_label = current_function->newLabel();
+    Operand end_label = current_function->newLabel();
     
     // Evaluate condition
     node->condition->accept(this);
-    std::string cond_result = last_result;
+    Operand cond_result = last_result;
     
     if (node->else_stmt) {
         current_function->addInstruction(IRInstruction(IROpcode::BRANCH, then_label, cond_result, else_label));
@@ -99,19 +107,19 @@ void IRGenerator::visit(IfStmt* node) {
 }
 
 void IRGenerator::visit(WhileStmt* node) {
-    std::string loop_label = current_function->newLabel();
-    std::string body_label = current_function->newLabel();
-    std::string end_label = current_function->newLabel();
+    Operand loop_label = current_function->newLabel();
+    Operand body_label = current_function->newLabel();
+    Operand end_label = current_function->newLabel();
     
-    std::string old_break = break_label;
-    std::string old_continue = continue_label;
+    Operand old_break = break_label;
+    Operand old_continue = continue_label;
     break_label = end_label;
     continue_label = loop_label;
     
     // Loop condition
     current_function->addInstruction(IRInstruction(IROpcode::LABEL, loop_label));
     node->condition->accept(this);
-    std::string cond_result = last_result;
+    Operand cond_result = last_result;
     current_function->addInstruction(IRInstruction(IROpcode::BRANCH, body_label, cond_result, end_label));
     
     // Loop body
@@ -155,63 +163,54 @@ void IRGenerator::visit(ExprStmt* node) {
 
 void IRGenerator::visit(BinaryExpr* node) {
     // Handle assignment specially
-    if (node->op == "=") {
+    if (node->op == BinaryOp::ASSIGN) {
         // Get the variable name from the left side
-        IdentExpr* ident = dynamic_cast<IdentExpr*>(node->left.get());
+        IdentExpr* ident = dynamic_cast<IdentExpr*>(node->left);
         if (!ident) {
             throw std::runtime_error("Left side of assignment must be an identifier");
         }
         
         // Evaluate the right side
         node->right->accept(this);
-        std::string right_result = last_result;
+        Operand right_result = last_result;
         
         // Store the value
-        current_function->addInstruction(IRInstruction(IROpcode::STORE, ident->name, right_result));
+        current_function->addInstruction(IRInstruction(IROpcode::STORE, Operand::var(ident->name), right_result));
         last_result = right_result;
         return;
     }
     
     node->left->accept(this);
-    std::string left_result = last_result;
+    Operand left_result = last_result;
     
     node->right->accept(this);
-    std::string right_result = last_result;
-    
-    std::string temp = current_function->newTemp();
+    Operand right_result = last_result;
     
-    IROpcode opcode;
-    if (node->op == "+") opcode = IROpcode::ADD;
-    else if (node->op == "-") opcode = IROpcode::SUB;
-    else if (node->op == "*") opcode = IROpcode::MUL;
-    else if (node->op == "/") opcode = IROpcode::DIV;
-    else if (node->op == "%") opcode = IROpcode::MOD;
-    else if (node->op == "==") opcode = IROpcode::EQ;
-    else if (node->op == "!=") opcode = IROpcode::NE;
-    else if (node->op == "<") opcode = IROpcode::LT;
-    else if (node->op == "<=") opcode = IROpcode::LE;
-    else if (node->op == ">") opcode = IROpcode::GT;
-    else if (node->op == ">=") opcode = IROpcode::GE;
-    else if (node->op == "&&") opcode = IROpcode::AND;
-    else if (node->op == "||") opcode = IROpcode::OR;
-    else throw std::runtime_error("Unknown binary operator: " + node->op);
+    Operand temp = current_function->newTemp();
     
+    IROpcode opcode = BINARY_OPCODES[static_cast<size_t>(node->op)];
     current_function->addInstruction(IRInstruction(opcode, temp, left_result, right_result));
     last_result = temp;
 }
 
 void IRGenerator::visit(UnaryExpr* node) {
     node->operand->accept(this);
-    std::string operand_result = last_result;
+    Operand operand_result = last_result;
     
-    std::string temp = current_function->newTemp();
+    Operand temp = current_function->newTemp();
     
-    if (node->op == "-") {
-        current_function->addInstruction(IRInstruction(IROpcode::SUB, temp, "0", operand_result));
-    } else if (node->op == "!") {
-        current_function->addInstruction(IRInstruction(IROpcode::NOT, temp, operand_result));
-    } else if (node->op == "+") {
-        temp = operand_result;  // Unary plus does nothing
+    switch (node->op) {
+        case UnaryOp::MINUS:
+            current_function->addInstruction(IRInstruction(IROpcode::SUB, temp, Operand::imm(0), operand_result));
+            break;
+        case UnaryOp::NOT:
+            current_function->addInstruction(IRInstruction(IROpcode::NOT, temp, operand_result));
+            break;
+        case UnaryOp::PLUS:
+            temp = operand_result;  // Unary plus does nothing
+            break;
+        default:
+            break;
     }
     
     last_result = temp;
@@ -225,44 +224,44 @@ void IRGenerator::visit(CallExpr* node) {
     }
     
     // Call function
-    std::string temp = current_function->newTemp();
-    current_function->addInstruction(IRInstruction(IROpcode::CALL, temp, node->func_name));
+    Operand temp = current_function->newTemp();
+    current_function->addInstruction(IRInstruction(IROpcode::CALL, temp, Operand::var(node->func_name)));
     last_result = temp;
 }
 
 void IRGenerator::visit(IdentExpr* node) {
     // Load variable value
-    std::string temp = current_function->newTemp();
-    current_function->addInstruction(IRInstruction(IROpcode::LOAD, temp, node->name));
+    Operand temp = current_function->newTemp();
+    current_function->addInstruction(IRInstruction(IROpcode::LOAD, temp, Operand::var(node->name)));
     last_result = temp;
 }
 
 void IRGenerator::visit(IntLiteralExpr* node) {
-    std::string temp = current_function->newTemp();
-    current_function->addInstruction(IRInstruction(IROpcode::CONST, temp, std::to_string(node->value)));
+    Operand temp = current_function->newTemp();
+    current_function->addInstruction(IRInstruction(IROpcode::CONST, temp, Operand::imm(node->value)));
     last_result = temp;
 }
 
 void IRGenerator::visit(CharLiteralExpr* node) {
-    std::string temp = current_function->newTemp();
-    current_function->addInstruction(IRInstruction(IROpcode::CONST, temp, std::to_string(node->value)));
+    Operand temp = current_function->newTemp();
+    current_function->addInstruction(IRInstruction(IROpcode::CONST, temp, Operand::imm(node->value)));
     last_result = temp;
 }
 
 void IRGenerator::visit(StringLiteralExpr* node) {
     // For now, treat strings as pointers to const data
     // In a real implementation, this would create a string constant in .rodata
-    std::string temp = current_function->newTemp();
-    current_function->addInstruction(IRInstruction(IROpcode::CONST, temp, "\"" + node->value + "\""));
+    Operand temp = current_function->newTemp();
+    current_function->addInstruction(IRInstruction(IROpcode::CONST, temp, Operand::var(Symbol("\"" + std::string(node->value) + "\""))));
     last_result = temp;
 }
 
 void IRGenerator::visit(ArrayAccess* node) {
     node->index->accept(this);
-    std::string index_result = last_result;
+    Operand index_result = last_result;
     
-    std::string temp = current_function->newTemp();
+    Operand temp = current_function->newTemp();
     // This is simplified - real array access needs offset calculation
-    current_function->addInstruction(IRInstruction(IROpcode::LOAD, temp, node->array_name + "[" + index_result + "]"));
+    current_function->addInstruction(IRInstruction(IROpcode::LOAD, temp, Operand::var(Symbol(node->array_name.toString() + "[" + index_result.toString() + "]"))));
     last_result = temp;
 }
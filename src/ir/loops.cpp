@@ -0,0 +1,75 @@
+#include "loops.h"
+#include <algorithm>
+
+LoopInfo::LoopInfo(const IRFunction& func, const DominatorTree& dominators)
+    : innermost(func.blocks.size(), -1) {
+    // One loop per header, its body found by walking predecessors back
+    // from the latches
+    std::vector<int> in_body(func.blocks.size(), -1);
+    for (int header : dominators.reversePostorder()) {
+        Loop loop{header, -1, 1, {header}, {}, {}};
+        for (int pred : func.blocks[static_cast<size_t>(header)].preds) {
+            if (dominators.dominates(header, pred)) {
+                loop.latches.push_back(pred);
+            }
+        }
+        if (loop.latches.empty()) {
+            continue;
+        }
+        in_body[static_cast<size_t>(header)] = header;
+        std::vector<int> worklist;
+        for (int latch : loop.latches) {
+            if (in_body[static_cast<size_t>(latch)] != header) {
+                in_body[static_cast<size_t>(latch)] = header;
+                worklist.push_back(latch);
+            }
+        }
+        while (!worklist.empty()) {
+            int block = worklist.back();
+            worklist.pop_back();
+            loop.blocks.push_back(block);
+            for (int pred : func.blocks[static_cast<size_t>(block)].preds) {
+                if (dominators.reachable(pred) && in_body[static_cast<size_t>(pred)] != header) {
+                    in_body[static_cast<size_t>(pred)] = header;
+                    worklist.push_back(pred);
+                }
+            }
+        }
+        std::sort(loop.blocks.begin(), loop.blocks.end());
+        loop_list.push_back(std::move(loop));
+    }
+
+    // Natural loops are disjoint or nested, so a larger loop can only
+    // enclose a smaller one: assigning blocks from the largest loop down
+    // leaves each block with its innermost loop, and a loop's parent is
+    // whatever its header belonged to just before
+    std::stable_sort(loop_list.begin(), loop_list.end(), [](const Loop& a, const Loop& b) {
+        return a.blocks.size() > b.blocks.size();
+    });
+    for (size_t i = 0; i < loop_list.size(); i++) {
+        Loop& loop = loop_list[i];
+        loop.parent = innermost[static_cast<size_t>(loop.header)];
+        if (loop.parent >= 0) {
+            Loop& parent = loop_list[static_cast<size_t>(loop.parent)];
+            loop.depth = parent.depth + 1;
+            parent.children.push_back(static_cast<int>(i));
+        }
+        for (int block : loop.blocks) {
+            innermost[static_cast<size_t>(block)] = static_cast<int>(i);
+        }
+    }
+}
+
+int LoopInfo::depth(int block) const {
+    int loop = loopFor(block);
+    return loop < 0 ? 0 : loop_list[static_cast<size_t>(loop)].depth;
+}
+
+bool LoopInfo::contains(int loop, int block) const {
+    for (int inner = loopFor(block); inner >= 0; inner = loop_list[static_cast<size_t>(inner)].parent) {
+        if (inner == loop) {
+            return true;
+        }
+    }
+    return false;
+}
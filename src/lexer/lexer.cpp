@@ -1,23 +1,13 @@
 #include "lexer.h"
+#include "scan.h"
+#include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <stdexcept>
 
-Lexer::Lexer(const std::string& source) 
-    : source(source), position(0), line(1), column(1) {
+Lexer::Lexer(std::string_view source) 
+    : source(source), position(0), line(1), column(1), token_count(0), eof_reached(false) {
     current_char = source.empty() ? '\0' : source[0];
-    
-    // Initialize keywords
-    keywords["const"] = TokenType::CONST;
-    keywords["int"] = TokenType::INT;
-    keywords["void"] = TokenType::VOID;
-    keywords["char"] = TokenType::CHAR;
-    keywords["typedef"] = TokenType::TYPEDEF;
-    keywords["if"] = TokenType::IF;
-    keywords["else"] = TokenType::ELSE;
-    keywords["while"] = TokenType::WHILE;
-    keywords["break"] = TokenType::BREAK;
-    keywords["continue"] = TokenType::CONTINUE;
-    keywords["return"] = TokenType::RETURN;
 }
 
 void Lexer::advance() {
@@ -35,6 +25,37 @@ void Lexer::advance() {
     }
 }
 
+// Moves forward to `target`, keeping line/column exactly as the equivalent
+// run of advance() calls would, but counting newlines a vector at a time.
+void Lexer::advanceTo(size_t target) {
+    if (target <= position) {
+        return;
+    }
+    
+    if (!source.empty()) {
+        size_t last = std::min(target, source.length() - 1);
+        if (last > position) {
+            const char* base = source.data();
+            const char* last_newline = nullptr;
+            size_t newlines = scan::countNewlines(base + position + 1, base + last + 1, &last_newline);
+            if (newlines > 0) {
+                line += static_cast<int>(newlines);
+                column = 1 + static_cast<int>(base + last - last_newline);
+            } else {
+                column += static_cast<int>(last - position);
+            }
+            position = last;
+            current_char = source[position];
+        }
+    }
+    
+    if (target > position) {
+        // Stepping off the end leaves line/column on the last character
+        position = target;
+        current_char = '\0';
+    }
+}
+
 char Lexer::peek(int offset) const {
     size_t peek_pos = position + offset;
     if (peek_pos < source.length()) {
@@ -44,68 +65,87 @@ char Lexer::peek(int offset) const {
 }
 
 void Lexer::skipWhitespace() {
-    while (current_char != '\0' && std::isspace(current_char)) {
-        advance();
-    }
+    const char* end = source.data() + source.length();
+    const char* stop = scan::skipWhitespace(source.data() + position, end);
+    advanceTo(stop - source.data());
 }
 
 void Lexer::skipComment() {
+    const char* base = source.data();
+    const char* end = base + source.length();
     if (current_char == '/' && peek() == '/') {
-        // Single line comment
-        while (current_char != '\0' && current_char != '\n') {
-            advance();
-        }
+        // Single line comment: stop on the newline
+        advanceTo(scan::findLineEnd(base + position, end) - base);
     } else if (current_char == '/' && peek() == '*') {
-        // Multi-line comment
-        advance(); // skip '/'
-        advance(); // skip '*'
-        while (current_char != '\0') {
-            if (current_char == '*' && peek() == '/') {
-                advance(); // skip '*'
-                advance(); // skip '/'
-                break;
-            }
-            advance();
+        // Multi-line comment: skip past the closing "*/" if there is one
+        const char* close = scan::findBlockCommentEnd(base + position + 2, end);
+        if (close < end && *close == '*') {
+            advanceTo(close - base + 2);
+        } else {
+            advanceTo(close - base);
         }
     }
 }
 
+void Lexer::skipTrivia() {
+    while (current_char != '\0') {
+        if (std::isspace(current_char)) {
+            skipWhitespace();
+        } else if (current_char == '/' && (peek() == '/' || peek() == '*')) {
+            skipComment();
+        } else {
+            return;
+        }
+    }
+}
+
+void Lexer::seek(size_t start, int start_line) {
+    position = start;
+    line = start_line;
+    column = 1;
+    current_char = start < source.length() ? source[start] : '\0';
+}
+
 Token Lexer::number() {
     int start_line = line;
     int start_column = column;
-    std::string num_str;
+    size_t start = position;
     
-    while (current_char != '\0' && std::isdigit(current_char)) {
-        num_str += current_char;
-        advance();
-    }
+    const char* end = source.data() + source.length();
+    advanceTo(scan::skipDigits(source.data() + position, end) - source.data());
     
-    int value = std::stoi(num_str);
+    std::string_view num_str = source.substr(start, position - start);
+    int value = 0;
+    auto [ptr, ec] = std::from_chars(num_str.data(), num_str.data() + num_str.size(), value);
+    if (ec != std::errc()) {
+        throw std::runtime_error("Integer literal out of range: " + std::string(num_str));
+    }
     return Token(TokenType::INT_LITERAL, num_str, start_line, start_column, value);
 }
 
 Token Lexer::identifier() {
     int start_line = line;
     int start_column = column;
-    std::string id_str;
+    size_t start = position;
     
-    while (current_char != '\0' && (std::isalnum(current_char) || current_char == '_')) {
-        id_str += current_char;
-        advance();
-    }
+    const char* end = source.data() + source.length();
+    advanceTo(scan::skipIdentChars(source.data() + position, end) - source.data());
     
-    // Check if it's a keyword
-    auto it = keywords.find(id_str);
-    if (it != keywords.end()) {
-        return Token(it->second, id_str, start_line, start_column);
-    }
+    std::string_view id_str = source.substr(start, position - start);
     
-    return Token(TokenType::IDENT, id_str, start_line, start_column);
+    // IDENT unless it's a keyword
+    TokenType type = lookupKeyword(id_str);
+    Token token(type, id_str, start_line, start_column);
+    if (type == TokenType::IDENT) {
+        token.symbol = Symbol(id_str);
+    }
+    return token;
 }
 
 Token Lexer::charLiteral() {
     int start_line = line;
     int start_column = column;
+    size_t start = position;
     advance(); // skip opening '
     
     if (current_char == '\0') {
@@ -113,88 +153,93 @@ Token Lexer::charLiteral() {
     }
     
     int value = 0;
-    std::string lexeme = "'";
     
     if (current_char == '\\') {
         advance();
-        lexeme += '\\';
         // Handle escape sequences
         switch (current_char) {
-            case 'n': value = '\n'; lexeme += 'n'; break;
-            case 't': value = '\t'; lexeme += 't'; break;
-            case 'r': value = '\r'; lexeme += 'r'; break;
-            case '0': value = '\0'; lexeme += '0'; break;
-            case '\\': value = '\\'; lexeme += '\\'; break;
-            case '\'': value = '\''; lexeme += '\''; break;
-            default: value = current_char; lexeme += current_char; break;
+            case 'n': value = '\n'; break;
+            case 't': value = '\t'; break;
+            case 'r': value = '\r'; break;
+            case '0': value = '\0'; break;
+            case '\\': value = '\\'; break;
+            case '\'': value = '\''; break;
+            default: value = current_char; break;
         }
         advance();
     } else {
         value = current_char;
-        lexeme += current_char;
         advance();
     }
     
     if (current_char != '\'') {
         throw std::runtime_error("Expected closing ' in character literal");
     }
-    lexeme += '\'';
     advance(); // skip closing '
     
+    std::string_view lexeme = source.substr(start, position - start);
     return Token(TokenType::CHAR_LITERAL, lexeme, start_line, start_column, value);
 }
 
 Token Lexer::stringLiteral() {
     int start_line = line;
     int start_column = column;
+    size_t start = position;
     advance(); // skip opening "
     
-    std::string value;
-    std::string lexeme = "\"";
+    // Only literals containing escapes need decoded storage; everything
+    // else is returned as a view of the text between the quotes.
+    size_t body_start = position;
+    bool has_escape = false;
     
     while (current_char != '\0' && current_char != '"') {
         if (current_char == '\\') {
-            advance();
-            lexeme += '\\';
-            // Handle escape sequences
-            switch (current_char) {
-                case 'n': value += '\n'; lexeme += 'n'; break;
-                case 't': value += '\t'; lexeme += 't'; break;
-                case 'r': value += '\r'; lexeme += 'r'; break;
-                case '0': value += '\0'; lexeme += '0'; break;
-                case '\\': value += '\\'; lexeme += '\\'; break;
-                case '"': value += '"'; lexeme += '"'; break;
-                default: value += current_char; lexeme += current_char; break;
-            }
-            advance();
-        } else {
-            value += current_char;
-            lexeme += current_char;
+            has_escape = true;
             advance();
         }
+        advance();
     }
     
     if (current_char != '"') {
         throw std::runtime_error("Unterminated string literal");
     }
-    lexeme += '"';
+    std::string_view body = source.substr(body_start, position - body_start);
     advance(); // skip closing "
     
+    std::string_view value = body;
+    if (has_escape) {
+        std::string decoded;
+        decoded.reserve(body.size());
+        for (size_t i = 0; i < body.size(); i++) {
+            if (body[i] != '\\') {
+                decoded += body[i];
+                continue;
+            }
+            // Handle escape sequences
+            switch (body[++i]) {
+                case 'n': decoded += '\n'; break;
+                case 't': decoded += '\t'; break;
+                case 'r': decoded += '\r'; break;
+                case '0': decoded += '\0'; break;
+                default: decoded += body[i]; break;
+            }
+        }
+        literal_storage.push_back(std::move(decoded));
+        value = literal_storage.back();
+    }
+    
+    std::string_view lexeme = source.substr(start, position - start);
     return Token(TokenType::STRING_LITERAL, lexeme, start_line, start_column, value);
 }
 
+// Token spanning [start, position) of the source
+Token Lexer::makeToken(TokenType type, size_t start, int start_line, int start_column) const {
+    return Token(type, source.substr(start, position - start), start_line, start_column);
+}
+
 Token Lexer::getNextToken() {
-    while (current_char != '\0') {
-        if (std::isspace(current_char)) {
-            skipWhitespace();
-            continue;
-        }
-        
-        if (current_char == '/' && (peek() == '/' || peek() == '*')) {
-            skipComment();
-            continue;
-        }
-        
+    skipTrivia();
+    if (current_char != '\0') {
         int start_line = line;
         int start_column = column;
         
@@ -217,6 +262,7 @@ Token Lexer::getNextToken() {
         }
         
         // Single character tokens
+        size_t start = position;
         char ch = current_char;
         advance();
         
@@ -224,72 +270,94 @@ Token Lexer::getNextToken() {
             case '+':
                 if (current_char == '+') {
                     advance();
-                    return Token(TokenType::INCREMENT, "++", start_line, start_column);
+                    return makeToken(TokenType::INCREMENT, start, start_line, start_column);
                 }
-                return Token(TokenType::PLUS, "+", start_line, start_column);
+                return makeToken(TokenType::PLUS, start, start_line, start_column);
             case '-':
                 if (current_char == '-') {
                     advance();
-                    return Token(TokenType::DECREMENT, "--", start_line, start_column);
+                    return makeToken(TokenType::DECREMENT, start, start_line, start_column);
                 } else if (current_char == '>') {
                     advance();
-                    return Token(TokenType::ARROW, "->", start_line, start_column);
+                    return makeToken(TokenType::ARROW, start, start_line, start_column);
                 }
-                return Token(TokenType::MINUS, "-", start_line, start_column);
-            case '*': return Token(TokenType::MULT, "*", start_line, start_column);
-            case '/': return Token(TokenType::DIV, "/", start_line, start_column);
-            case '%': return Token(TokenType::MOD, "%", start_line, start_column);
-            case '(': return Token(TokenType::LPAREN, "(", start_line, start_column);
-            case ')': return Token(TokenType::RPAREN, ")", start_line, start_column);
-            case '{': return Token(TokenType::LBRACE, "{", start_line, start_column);
-            case '}': return Token(TokenType::RBRACE, "}", start_line, start_column);
-            case '[': return Token(TokenType::LBRACKET, "[", start_line, start_column);
-            case ']': return Token(TokenType::RBRACKET, "]", start_line, start_column);
-            case ';': return Token(TokenType::SEMICOLON, ";", start_line, start_column);
-            case ',': return Token(TokenType::COMMA, ",", start_line, start_column);
-            case '.': return Token(TokenType::DOT, ".", start_line, start_column);
+                return makeToken(TokenType::MINUS, start, start_line, start_column);
+            case '*': return makeToken(TokenType::MULT, start, start_line, start_column);
+            case '/': return makeToken(TokenType::DIV, start, start_line, start_column);
+            case '%': return makeToken(TokenType::MOD, start, start_line, start_column);
+            case '(': return makeToken(TokenType::LPAREN, start, start_line, start_column);
+            case ')': return makeToken(TokenType::RPAREN, start, start_line, start_column);
+            case '{': return makeToken(TokenType::LBRACE, start, start_line, start_column);
+            case '}': return makeToken(TokenType::RBRACE, start, start_line, start_column);
+            case '[': return makeToken(TokenType::LBRACKET, start, start_line, start_column);
+            case ']': return makeToken(TokenType::RBRACKET, start, start_line, start_column);
+            case ';': return makeToken(TokenType::SEMICOLON, start, start_line, start_column);
+            case ',': return makeToken(TokenType::COMMA, start, start_line, start_column);
+            case '.': return makeToken(TokenType::DOT, start, start_line, start_column);
             case '!':
                 if (current_char == '=') {
                     advance();
-                    return Token(TokenType::NE, "!=", start_line, start_column);
+                    return makeToken(TokenType::NE, start, start_line, start_column);
                 }
-                return Token(TokenType::NOT, "!", start_line, start_column);
+                return makeToken(TokenType::NOT, start, start_line, start_column);
             case '=':
                 if (current_char == '=') {
                     advance();
-                    return Token(TokenType::EQ, "==", start_line, start_column);
+                    return makeToken(TokenType::EQ, start, start_line, start_column);
                 }
-                return Token(TokenType::ASSIGN, "=", start_line, start_column);
+                return makeToken(TokenType::ASSIGN, start, start_line, start_column);
             case '<':
                 if (current_char == '=') {
                     advance();
-                    return Token(TokenType::LE, "<=", start_line, start_column);
+                    return makeToken(TokenType::LE, start, start_line, start_column);
                 }
-                return Token(TokenType::LT, "<", start_line, start_column);
+                return makeToken(TokenType::LT, start, start_line, start_column);
             case '>':
                 if (current_char == '=') {
                     advance();
-                    return Token(TokenType::GE, ">=", start_line, start_column);
+                    return makeToken(TokenType::GE, start, start_line, start_column);
                 }
-                return Token(TokenType::GT, ">", start_line, start_column);
+                return makeToken(TokenType::GT, start, start_line, start_column);
             case '&':
                 if (current_char == '&') {
                     advance();
-                    return Token(TokenType::AND, "&&", start_line, start_column);
+                    return makeToken(TokenType::AND, start, start_line, start_column);
                 }
-                return Token(TokenType::AMPERSAND, "&", start_line, start_column);
+                return makeToken(TokenType::AMPERSAND, start, start_line, start_column);
             case '|':
                 if (current_char == '|') {
                     advance();
-                    return Token(TokenType::OR, "||", start_line, start_column);
+                    return makeToken(TokenType::OR, start, start_line, start_column);
                 }
                 break;
         }
         
-        return Token(TokenType::UNKNOWN, std::string(1, ch), start_line, start_column);
+        return Token(TokenType::UNKNOWN, source.substr(start, 1), start_line, start_column);
     }
     
-    return Token(TokenType::END_OF_FILE, "", line, column);
+    return Token(TokenType::END_OF_FILE, source.substr(source.length()), line, column);
+}
+
+Token Lexer::next() {
+    Token token = getNextToken();
+    if (!eof_reached) {
+        token_count++;
+        eof_reached = token.type == TokenType::END_OF_FILE;
+    }
+    return token;
+}
+
+TokenBuffer Lexer::tokenizePacked() {
+    TokenBuffer buffer(source);
+    // Generated sources average roughly one token per five bytes
+    buffer.reserve(source.length() / 5 + 1);
+    Token token = getNextToken();
+    while (token.type != TokenType::END_OF_FILE) {
+        buffer.append(token);
+        token = getNextToken();
+    }
+    buffer.append(token);  // Add EOF token
+    return buffer;
 }
 
 std::vector<Token> Lexer::tokenize() {
@@ -0,0 +1,197 @@
+#include "parallel_lexer.h"
+#include "lexer.h"
+#include "scan.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr size_t NO_MERGE = static_cast<size_t>(-1);
+
+ParallelLexer::ParallelLexer(std::string_view source, ThreadPool& pool, size_t min_chunk)
+    : source(source), pool(pool), min_chunk(std::max<size_t>(min_chunk, 1)) {}
+
+// Cuts the input at newlines near evenly spaced offsets. Several chunks per
+// thread keep the workers busy when some chunks lex slower than others.
+std::vector<ParallelLexer::Chunk> ParallelLexer::split() const {
+    std::vector<Chunk> chunks;
+    size_t parts = std::min(source.length() / min_chunk, pool.size() * 4);
+    const char* base = source.data();
+    size_t begin = 0;
+    for (size_t i = 1; i < parts; i++) {
+        size_t target = std::max(source.length() / parts * i, begin + 1);
+        if (target >= source.length()) {
+            break;
+        }
+        const void* newline = std::memchr(base + target, '\n', source.length() - target);
+        if (!newline) {
+            break;
+        }
+        size_t end = static_cast<const char*>(newline) - base;
+        chunks.push_back(Chunk{begin, end, 0, {}, {}, false});
+        begin = end;
+    }
+    chunks.push_back(Chunk{begin, source.length(), 0, {}, {}, false});
+    return chunks;
+}
+
+// Lexes the tokens of `chunk` that start at or after `from`, which must be
+// a position between tokens. With `converge`, stops as soon as a token
+// starts where one of converge's tokens does: from there on both would
+// produce the same tokens.
+void ParallelLexer::lexChunk(Chunk& chunk, size_t from, const Speculation* converge,
+                             Speculation& out) const {
+    Lexer lexer(source);
+    lexer.seek(chunk.begin, 1);
+    lexer.advanceTo(from);
+
+    out.start = from;
+    out.merge_index = NO_MERGE;
+    out.failed = false;
+    size_t next = 0;
+    lexer.skipTrivia();
+    while (lexer.current_char != '\0' && lexer.position < chunk.end) {
+        if (converge) {
+            const std::vector<Token>& other = converge->tokens;
+            while (next < other.size() &&
+                   static_cast<size_t>(other[next].lexeme.data() - source.data()) < lexer.position) {
+                next++;
+            }
+            if (next < other.size() &&
+                static_cast<size_t>(other[next].lexeme.data() - source.data()) == lexer.position) {
+                out.merge_index = next;
+                break;
+            }
+        }
+        out.tokens.push_back(lexer.getNextToken());
+        lexer.skipTrivia();
+    }
+    out.resume = lexer.position;
+    out.literals = std::move(lexer.literal_storage);
+}
+
+void ParallelLexer::speculate(Chunk& chunk) const {
+    const char* base = source.data();
+    // The '\n' a chunk starts on is line 1 of its speculations and is
+    // counted by the chunk before it. Like the Lexer, a '\n' at offset 0
+    // does not start a new line.
+    const char* count_from = base + chunk.begin + 1;
+    const char* count_to = base + std::min(chunk.end + 1, source.length());
+    const char* last_newline = nullptr;
+    if (count_from < count_to) {
+        chunk.newlines = scan::countNewlines(count_from, count_to, &last_newline);
+    }
+
+    // Errors only matter if the real token stream runs into them, which
+    // tokenize() finds out by re-lexing
+    try {
+        lexChunk(chunk, chunk.begin, nullptr, chunk.code);
+    } catch (const std::runtime_error&) {
+        chunk.code.failed = true;
+    }
+
+    if (chunk.begin == 0) {
+        return;
+    }
+    const char* close = scan::findBlockCommentEnd(base + chunk.begin, base + chunk.end);
+    if (close < base + chunk.end && *close == '*') {
+        chunk.has_comment_end = true;
+        try {
+            lexChunk(chunk, close - base + 2, chunk.code.failed ? nullptr : &chunk.code, chunk.comment);
+        } catch (const std::runtime_error&) {
+            chunk.comment.failed = true;
+        }
+    }
+}
+
+// Appends the tokens of `spec` from the real token start `resume` onward,
+// if `spec` is in step with the real token stream there
+bool ParallelLexer::splice(Chunk& chunk, Speculation& spec, int line_offset, size_t& resume,
+                           std::vector<Token>& tokens) {
+    if (spec.failed) {
+        return false;
+    }
+    size_t first = 0;
+    if (resume != spec.start) {
+        auto it = std::lower_bound(spec.tokens.begin(), spec.tokens.end(), resume,
+            [this](const Token& token, size_t offset) {
+                return static_cast<size_t>(token.lexeme.data() - source.data()) < offset;
+            });
+        if (it == spec.tokens.end() || static_cast<size_t>(it->lexeme.data() - source.data()) != resume) {
+            return false;
+        }
+        first = it - spec.tokens.begin();
+    }
+    Speculation* tail = nullptr;
+    if (spec.merge_index != NO_MERGE) {
+        if (chunk.code.failed) {
+            return false;
+        }
+        tail = &chunk.code;
+    }
+
+    for (size_t i = first; i < spec.tokens.size(); i++) {
+        tokens.push_back(spec.tokens[i]);
+        tokens.back().line += line_offset;
+    }
+    literal_storage.push_back(std::move(spec.literals));
+    resume = spec.resume;
+    if (tail) {
+        for (size_t i = spec.merge_index; i < tail->tokens.size(); i++) {
+            tokens.push_back(tail->tokens[i]);
+            tokens.back().line += line_offset;
+        }
+        literal_storage.push_back(std::move(tail->literals));
+        resume = tail->resume;
+    }
+    return true;
+}
+
+std::vector<Token> ParallelLexer::tokenize() {
+    // The Lexer stops at a NUL byte, which no chunk after it could know
+    bool has_nul = std::memchr(source.data(), '\0', source.length()) != nullptr;
+    std::vector<Chunk> chunks;
+    if (pool.size() > 1 && !has_nul) {
+        chunks = split();
+    }
+    if (chunks.size() < 2) {
+        Lexer lexer(source);
+        std::vector<Token> tokens = lexer.tokenize();
+        literal_storage.push_back(std::move(lexer.literal_storage));
+        return tokens;
+    }
+
+    pool.parallelFor(chunks.size(), [this, &chunks](size_t i) { speculate(chunks[i]); });
+
+    size_t total = 1;
+    for (const Chunk& chunk : chunks) {
+        total += chunk.code.tokens.size();
+    }
+    std::vector<Token> tokens;
+    tokens.reserve(total);
+
+    // `resume` is where the real token stream has its next token
+    size_t resume = 0;
+    int line_offset = 0;
+    for (Chunk& chunk : chunks) {
+        if (resume < chunk.end &&
+            !splice(chunk, chunk.code, line_offset, resume, tokens) &&
+            !(chunk.has_comment_end && splice(chunk, chunk.comment, line_offset, resume, tokens))) {
+            // Out of step with both guesses (e.g. inside a multi-line string
+            // literal): lex for real from the known position
+            Speculation repair;
+            lexChunk(chunk, resume, chunk.code.failed ? nullptr : &chunk.code, repair);
+            splice(chunk, repair, line_offset, resume, tokens);
+        }
+        line_offset += static_cast<int>(chunk.newlines);
+    }
+
+    // END_OF_FILE sits on the last character, as in Lexer::getNextToken
+    size_t last_newline = source.rfind('\n');
+    int column = static_cast<int>(source.length());
+    if (last_newline != std::string_view::npos && last_newline > 0) {
+        column = static_cast<int>(source.length() - last_newline);
+    }
+    tokens.emplace_back(TokenType::END_OF_FILE, source.substr(source.length()),
+                        1 + line_offset, std::max(column, 1));
+    return tokens;
+}
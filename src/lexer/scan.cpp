@@ -0,0 +1,426 @@
+#include "scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace scan {
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Scalar implementation (also used for the tails of the vector loops)
+// ---------------------------------------------------------------------------
+
+inline bool isSpace(unsigned char c) {
+    return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+}
+
+inline bool isDigit(unsigned char c) {
+    return static_cast<unsigned char>(c - '0') <= 9;
+}
+
+inline bool isIdentChar(unsigned char c) {
+    return static_cast<unsigned char>((c | 0x20) - 'a') <= 'z' - 'a' || isDigit(c) || c == '_';
+}
+
+const char* scalarSkipWhitespace(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) {
+        p++;
+    }
+    return p;
+}
+
+const char* scalarSkipIdentChars(const char* p, const char* end) {
+    while (p < end && isIdentChar(*p)) {
+        p++;
+    }
+    return p;
+}
+
+const char* scalarSkipDigits(const char* p, const char* end) {
+    while (p < end && isDigit(*p)) {
+        p++;
+    }
+    return p;
+}
+
+const char* scalarFindLineEnd(const char* p, const char* end) {
+    while (p < end && *p != '\n' && *p != '\0') {
+        p++;
+    }
+    return p;
+}
+
+const char* scalarFindBlockCommentEnd(const char* p, const char* end) {
+    while (p < end && *p != '\0') {
+        if (*p == '*' && p + 1 < end && p[1] == '/') {
+            return p;
+        }
+        p++;
+    }
+    return p;
+}
+
+size_t scalarCountNewlines(const char* p, const char* end, const char** last_newline) {
+    size_t count = 0;
+    for (; p < end; p++) {
+        if (*p == '\n') {
+            count++;
+            *last_newline = p;
+        }
+    }
+    return count;
+}
+
+#ifdef SCAN_X86
+
+// ---------------------------------------------------------------------------
+// SSE2 implementation: 16 bytes per step. SSE2 is part of the x86-64
+// baseline, so no target attribute is needed.
+// ---------------------------------------------------------------------------
+
+// Per-byte unsigned `v - base <= span`, as a compare mask
+inline __m128i sse2InRange(__m128i v, char base, char span) {
+    __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(base));
+    return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(span)), shifted);
+}
+
+inline unsigned sse2WhitespaceMask(__m128i v) {
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    return _mm_movemask_epi8(_mm_or_si128(space, sse2InRange(v, '\t', '\r' - '\t')));
+}
+
+inline unsigned sse2DigitMask(__m128i v) {
+    return _mm_movemask_epi8(sse2InRange(v, '0', 9));
+}
+
+inline unsigned sse2IdentMask(__m128i v) {
+    __m128i alpha = sse2InRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z' - 'a');
+    __m128i digit = sse2InRange(v, '0', 9);
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), underscore));
+}
+
+inline __m128i sse2Load(const char* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+const char* sse2SkipWhitespace(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        unsigned stop = ~sse2WhitespaceMask(sse2Load(p)) & 0xFFFF;
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+    }
+    return scalarSkipWhitespace(p, end);
+}
+
+const char* sse2SkipIdentChars(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        unsigned stop = ~sse2IdentMask(sse2Load(p)) & 0xFFFF;
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+    }
+    return scalarSkipIdentChars(p, end);
+}
+
+const char* sse2SkipDigits(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        unsigned stop = ~sse2DigitMask(sse2Load(p)) & 0xFFFF;
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+    }
+    return scalarSkipDigits(p, end);
+}
+
+const char* sse2FindLineEnd(const char* p, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i nul = _mm_setzero_si128();
+    for (; end - p >= 16; p += 16) {
+        __m128i v = sse2Load(p);
+        unsigned stop = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, nul)));
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+    }
+    return scalarFindLineEnd(p, end);
+}
+
+const char* sse2FindBlockCommentEnd(const char* p, const char* end) {
+    const __m128i star = _mm_set1_epi8('*');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i nul = _mm_setzero_si128();
+    // The second load reads one byte ahead to pair each '*' with its successor
+    for (; end - p >= 17; p += 16) {
+        __m128i v = sse2Load(p);
+        __m128i next = sse2Load(p + 1);
+        __m128i close = _mm_and_si128(_mm_cmpeq_epi8(v, star), _mm_cmpeq_epi8(next, slash));
+        unsigned stop = _mm_movemask_epi8(_mm_or_si128(close, _mm_cmpeq_epi8(v, nul)));
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+    }
+    return scalarFindBlockCommentEnd(p, end);
+}
+
+size_t sse2CountNewlines(const char* p, const char* end, const char** last_newline) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+    for (; end - p >= 16; p += 16) {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(sse2Load(p), newline));
+        if (mask) {
+            count += __builtin_popcount(mask);
+            *last_newline = p + (31 - __builtin_clz(mask));
+        }
+    }
+    return count + scalarCountNewlines(p, end, last_newline);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 implementation: 32 bytes per step, compiled for AVX2 regardless of
+// the global flags and only called when the CPU reports support.
+// ---------------------------------------------------------------------------
+
+#define SCAN_AVX2 __attribute__((target("avx2")))
+
+SCAN_AVX2 inline __m256i avx2InRange(__m256i v, char base, char span) {
+    __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(base));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(span)), shifted);
+}
+
+SCAN_AVX2 inline unsigned avx2WhitespaceMask(__m256i v) {
+    __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+    return _mm256_movemask_epi8(_mm256_or_si256(space, avx2InRange(v, '\t', '\r' - '\t')));
+}
+
+SCAN_AVX2 inline unsigned avx2DigitMask(__m256i v) {
+    return _mm256_movemask_epi8(avx2InRange(v, '0', 9));
+}
+
+SCAN_AVX2 inline unsigned avx2IdentMask(__m256i v) {
+    __m256i alpha = avx2InRange(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z' - 'a');
+    __m256i digit = avx2InRange(v, '0', 9);
+    __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    return _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), underscore));
+}
+
+SCAN_AVX2 inline __m256i avx2Load(const char* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+SCAN_AVX2 const char* avx2SkipWhitespace(const char* p, const char* end) {
+    // Most runs are short: probe 16 bytes before switching to 32-byte steps
+    if (end - p >= 16) {
+        unsigned stop = ~sse2WhitespaceMask(sse2Load(p)) & 0xFFFF;
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+        p += 16;
+    }
+    for (; end - p >= 32; p += 32) {
+        unsigned stop = ~avx2WhitespaceMask(avx2Load(p));
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+    }
+    return sse2SkipWhitespace(p, end);
+}
+
+SCAN_AVX2 const char* avx2SkipIdentChars(const char* p, const char* end) {
+    // Most runs are short: probe 16 bytes before switching to 32-byte steps
+    if (end - p >= 16) {
+        unsigned stop = ~sse2IdentMask(sse2Load(p)) & 0xFFFF;
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+        p += 16;
+    }
+    for (; end - p >= 32; p += 32) {
+        unsigned stop = ~avx2IdentMask(avx2Load(p));
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+    }
+    return sse2SkipIdentChars(p, end);
+}
+
+SCAN_AVX2 const char* avx2SkipDigits(const char* p, const char* end) {
+    // Most runs are short: probe 16 bytes before switching to 32-byte steps
+    if (end - p >= 16) {
+        unsigned stop = ~sse2DigitMask(sse2Load(p)) & 0xFFFF;
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+        p += 16;
+    }
+    for (; end - p >= 32; p += 32) {
+        unsigned stop = ~avx2DigitMask(avx2Load(p));
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+    }
+    return sse2SkipDigits(p, end);
+}
+
+SCAN_AVX2 const char* avx2FindLineEnd(const char* p, const char* end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i nul = _mm256_setzero_si256();
+    for (; end - p >= 32; p += 32) {
+        __m256i v = avx2Load(p);
+        unsigned stop = _mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, nul)));
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+    }
+    return sse2FindLineEnd(p, end);
+}
+
+SCAN_AVX2 const char* avx2FindBlockCommentEnd(const char* p, const char* end) {
+    const __m256i star = _mm256_set1_epi8('*');
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i nul = _mm256_setzero_si256();
+    for (; end - p >= 33; p += 32) {
+        __m256i v = avx2Load(p);
+        __m256i next = avx2Load(p + 1);
+        __m256i close = _mm256_and_si256(_mm256_cmpeq_epi8(v, star), _mm256_cmpeq_epi8(next, slash));
+        unsigned stop = _mm256_movemask_epi8(_mm256_or_si256(close, _mm256_cmpeq_epi8(v, nul)));
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+    }
+    return sse2FindBlockCommentEnd(p, end);
+}
+
+SCAN_AVX2 size_t avx2CountNewlines(const char* p, const char* end, const char** last_newline) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    for (; end - p >= 32; p += 32) {
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(avx2Load(p), newline));
+        if (mask) {
+            count += __builtin_popcount(mask);
+            *last_newline = p + (31 - __builtin_clz(mask));
+        }
+    }
+    return count + sse2CountNewlines(p, end, last_newline);
+}
+
+#undef SCAN_AVX2
+
+#endif // SCAN_X86
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch
+// ---------------------------------------------------------------------------
+
+struct ScanTable {
+    Impl impl;
+    const char* (*skip_whitespace)(const char*, const char*);
+    const char* (*skip_ident_chars)(const char*, const char*);
+    const char* (*skip_digits)(const char*, const char*);
+    const char* (*find_line_end)(const char*, const char*);
+    const char* (*find_block_comment_end)(const char*, const char*);
+    size_t (*count_newlines)(const char*, const char*, const char**);
+};
+
+const ScanTable scalar_table = {
+    Impl::SCALAR, scalarSkipWhitespace, scalarSkipIdentChars, scalarSkipDigits,
+    scalarFindLineEnd, scalarFindBlockCommentEnd, scalarCountNewlines
+};
+
+#ifdef SCAN_X86
+const ScanTable sse2_table = {
+    Impl::SSE2, sse2SkipWhitespace, sse2SkipIdentChars, sse2SkipDigits,
+    sse2FindLineEnd, sse2FindBlockCommentEnd, sse2CountNewlines
+};
+
+const ScanTable avx2_table = {
+    Impl::AVX2, avx2SkipWhitespace, avx2SkipIdentChars, avx2SkipDigits,
+    avx2FindLineEnd, avx2FindBlockCommentEnd, avx2CountNewlines
+};
+#endif
+
+const ScanTable* tableFor(Impl impl) {
+#ifdef SCAN_X86
+    switch (impl) {
+        case Impl::AVX2:
+            return __builtin_cpu_supports("avx2") ? &avx2_table : nullptr;
+        case Impl::SSE2:
+            return &sse2_table;
+        case Impl::SCALAR:
+            return &scalar_table;
+    }
+    return nullptr;
+#else
+    return impl == Impl::SCALAR ? &scalar_table : nullptr;
+#endif
+}
+
+const ScanTable* detect() {
+    if (const ScanTable* table = tableFor(Impl::AVX2)) {
+        return table;
+    }
+    if (const ScanTable* table = tableFor(Impl::SSE2)) {
+        return table;
+    }
+    return &scalar_table;
+}
+
+const ScanTable*& active() {
+    static const ScanTable* table = detect();
+    return table;
+}
+
+} // namespace
+
+const char* skipWhitespace(const char* p, const char* end) {
+    return active()->skip_whitespace(p, end);
+}
+
+const char* skipIdentChars(const char* p, const char* end) {
+    return active()->skip_ident_chars(p, end);
+}
+
+const char* skipDigits(const char* p, const char* end) {
+    return active()->skip_digits(p, end);
+}
+
+const char* findLineEnd(const char* p, const char* end) {
+    return active()->find_line_end(p, end);
+}
+
+const char* findBlockCommentEnd(const char* p, const char* end) {
+    return active()->find_block_comment_end(p, end);
+}
+
+size_t countNewlines(const char* p, const char* end, const char** last_newline) {
+    return active()->count_newlines(p, end, last_newline);
+}
+
+Impl activeImpl() {
+    return active()->impl;
+}
+
+bool setImpl(Impl impl) {
+    const ScanTable* table = tableFor(impl);
+    if (!table) {
+        return false;
+    }
+    active() = table;
+    return true;
+}
+
+const char* implName(Impl impl) {
+    switch (impl) {
+        case Impl::SCALAR: return "scalar";
+        case Impl::SSE2: return "sse2";
+        case Impl::AVX2: return "avx2";
+    }
+    return "unknown";
+}
+
+} // namespace scan
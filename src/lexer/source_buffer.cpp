@@ -0,0 +1,82 @@
+#include "source_buffer.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceBuffer::SourceBuffer(const std::string& filename)
+    : data(nullptr), size(0), mapped(false) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            // The lexer walks the buffer front to back exactly once
+            ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(addr);
+            size = static_cast<size_t>(st.st_size);
+            mapped = true;
+        }
+    }
+    ::close(fd);
+
+    if (!mapped) {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open file: " + filename);
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        fallback = buffer.str();
+        data = fallback.data();
+        size = fallback.size();
+    }
+}
+
+SourceBuffer::~SourceBuffer() {
+    release();
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept
+    : data(other.data), size(other.size), mapped(other.mapped),
+      fallback(std::move(other.fallback)) {
+    if (!mapped) {
+        data = fallback.data();
+    }
+    other.data = nullptr;
+    other.size = 0;
+    other.mapped = false;
+}
+
+SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        data = other.data;
+        size = other.size;
+        mapped = other.mapped;
+        fallback = std::move(other.fallback);
+        if (!mapped) {
+            data = fallback.data();
+        }
+        other.data = nullptr;
+        other.size = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+void SourceBuffer::release() {
+    if (mapped && data) {
+        ::munmap(const_cast<char*>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+    mapped = false;
+}
@@ -0,0 +1,57 @@
+#include "symbol.h"
+#include <stdexcept>
+
+StringInterner::StringInterner() : next_id(1) {
+    for (auto& block : blocks) {
+        block.store(nullptr, std::memory_order_relaxed);
+    }
+    publish(0, std::string_view());
+}
+
+StringInterner::~StringInterner() {
+    for (auto& block : blocks) {
+        delete[] block.load(std::memory_order_relaxed);
+    }
+}
+
+StringInterner& StringInterner::global() {
+    static StringInterner interner;
+    return interner;
+}
+
+void StringInterner::publish(uint32_t id, std::string_view text) {
+    std::atomic<std::string_view*>& slot = blocks[id >> BLOCK_BITS];
+    std::string_view* block = slot.load(std::memory_order_acquire);
+    if (!block) {
+        // Ids are handed out in order, so at most a few threads race here
+        std::string_view* fresh = new std::string_view[BLOCK_SIZE];
+        if (slot.compare_exchange_strong(block, fresh, std::memory_order_acq_rel)) {
+            block = fresh;
+        } else {
+            delete[] fresh;
+        }
+    }
+    block[id & (BLOCK_SIZE - 1)] = text;
+}
+
+uint32_t StringInterner::intern(std::string_view text) {
+    if (text.empty()) {
+        return 0;
+    }
+
+    Shard& shard = shards[std::hash<std::string_view>()(text) % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.ids.find(text);
+    if (it != shard.ids.end()) {
+        return it->second;
+    }
+
+    uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    if ((id >> BLOCK_BITS) >= MAX_BLOCKS) {
+        throw std::runtime_error("Too many distinct identifiers");
+    }
+    std::string_view stored = shard.chars.copyString(text);
+    publish(id, stored);
+    shard.ids.emplace(stored, id);
+    return id;
+}
@@ -1,22 +1,29 @@
 #include "token.h"
 
-Token::Token(TokenType type, const std::string& lexeme, int line, int column)
-    : type(type), lexeme(lexeme), line(line), column(column), value(0), string_value("") {}
+Token::Token()
+    : type(TokenType::UNKNOWN), line(0), column(0), value(0) {}
 
-Token::Token(TokenType type, const std::string& lexeme, int line, int column, int value)
-    : type(type), lexeme(lexeme), line(line), column(column), value(value), string_value("") {}
+Token::Token(TokenType type, std::string_view lexeme, int line, int column)
+    : type(type), lexeme(lexeme), line(line), column(column), value(0) {}
 
-Token::Token(TokenType type, const std::string& lexeme, int line, int column, const std::string& str_val)
+Token::Token(TokenType type, std::string_view lexeme, int line, int column, int value)
+    : type(type), lexeme(lexeme), line(line), column(column), value(value) {}
+
+Token::Token(TokenType type, std::string_view lexeme, int line, int column, std::string_view str_val)
     : type(type), lexeme(lexeme), line(line), column(column), value(0), string_value(str_val) {}
 
 std::string Token::toString() const {
-    std::string result = "Token(" + tokenTypeToString(type) + ", '" + lexeme + "'";
+    std::string result = "Token(" + tokenTypeToString(type) + ", '";
+    result += lexeme;
+    result += "'";
     if (type == TokenType::INT_LITERAL) {
         result += ", value=" + std::to_string(value);
     } else if (type == TokenType::CHAR_LITERAL) {
         result += ", value=" + std::to_string(value);
     } else if (type == TokenType::STRING_LITERAL) {
-        result += ", string=\"" + string_value + "\"";
+        result += ", string=\"";
+        result += string_value;
+        result += "\"";
     }
     result += ", line=" + std::to_string(line) + ", col=" + std::to_string(column) + ")";
     return result;
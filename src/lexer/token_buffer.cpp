@@ -0,0 +1,141 @@
+#include "token_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+static_assert(static_cast<int>(TokenType::UNKNOWN) < 256, "TokenType must fit in a byte");
+
+LineTable::LineTable(std::string_view source) : source_size(source.size()) {
+    starts.push_back(0);
+    const char* base = source.data();
+    const char* end = base + source.size();
+    const char* p = source.empty() ? end : base + 1;
+    while (p < end) {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!newline) {
+            break;
+        }
+        starts.push_back(static_cast<uint32_t>(newline - base));
+        p = newline + 1;
+    }
+}
+
+// Offsets at or past the end (END_OF_FILE) report the last character's
+// position, as the Lexer does once it steps off the end of the input.
+uint32_t LineTable::clamp(uint32_t offset) const {
+    if (source_size == 0) {
+        return 0;
+    }
+    return std::min<uint32_t>(offset, static_cast<uint32_t>(source_size - 1));
+}
+
+int LineTable::line(uint32_t offset) const {
+    offset = clamp(offset);
+    return static_cast<int>(std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin());
+}
+
+int LineTable::column(uint32_t offset) const {
+    offset = clamp(offset);
+    return static_cast<int>(offset - starts[line(offset) - 1]) + 1;
+}
+
+TokenBuffer::TokenBuffer(std::string_view source) : source(source) {}
+
+const LineTable& TokenBuffer::lines() const {
+    if (!line_table) {
+        line_table = std::make_unique<LineTable>(source);
+    }
+    return *line_table;
+}
+
+void TokenBuffer::reserve(size_t count) {
+    types.reserve(count);
+    offsets.reserve(count);
+    lengths.reserve(count);
+    literals.reserve(count);
+}
+
+void TokenBuffer::append(const Token& token) {
+    types.push_back(static_cast<uint8_t>(token.type));
+    offsets.push_back(static_cast<uint32_t>(token.lexeme.data() - source.data()));
+    lengths.push_back(static_cast<uint32_t>(token.lexeme.size()));
+
+    uint32_t literal = 0;
+    switch (token.type) {
+        case TokenType::INT_LITERAL:
+        case TokenType::CHAR_LITERAL:
+            literal = static_cast<uint32_t>(token.value);
+            break;
+        case TokenType::IDENT:
+            literal = token.symbol.getId();
+            break;
+        case TokenType::STRING_LITERAL: {
+            std::string_view value = token.string_value;
+            bool in_source = value.data() >= source.data() &&
+                             value.data() + value.size() <= source.data() + source.size();
+            if (!in_source) {
+                // Decoded escapes live in the Lexer; keep our own copy
+                value = decoded.copyString(value);
+            }
+            literal = static_cast<uint32_t>(string_values.size());
+            string_values.push_back(value);
+            break;
+        }
+        default:
+            break;
+    }
+    literals.push_back(literal);
+}
+
+int TokenBuffer::value(size_t index) const {
+    TokenType t = type(index);
+    if (t == TokenType::INT_LITERAL || t == TokenType::CHAR_LITERAL) {
+        return static_cast<int>(literals[index]);
+    }
+    return 0;
+}
+
+std::string_view TokenBuffer::stringValue(size_t index) const {
+    if (type(index) == TokenType::STRING_LITERAL) {
+        return string_values[literals[index]];
+    }
+    return std::string_view();
+}
+
+Symbol TokenBuffer::symbol(size_t index) const {
+    if (type(index) == TokenType::IDENT) {
+        return Symbol::fromId(literals[index]);
+    }
+    return Symbol();
+}
+
+Token TokenBuffer::token(size_t index, bool with_position) const {
+    int token_line = with_position ? line(index) : 0;
+    int token_column = with_position ? column(index) : 0;
+    Token result(type(index), lexeme(index), token_line, token_column, value(index));
+    result.string_value = stringValue(index);
+    result.symbol = symbol(index);
+    return result;
+}
+
+size_t TokenBuffer::memoryUsage() const {
+    return types.capacity() * sizeof(uint8_t) +
+           offsets.capacity() * sizeof(uint32_t) +
+           lengths.capacity() * sizeof(uint32_t) +
+           literals.capacity() * sizeof(uint32_t) +
+           string_values.capacity() * sizeof(std::string_view) +
+           decoded.bytesReserved();
+}
+
+TokenBufferSource::TokenBufferSource(const TokenBuffer& buffer, size_t start)
+    : buffer(buffer), index(start) {}
+
+Token TokenBufferSource::next() {
+    if (index < buffer.size()) {
+        return buffer.token(index++, false);
+    }
+    return buffer.token(buffer.size() - 1, false);  // Return EOF
+}
+
+int TokenBufferSource::line(const Token& token) const {
+    return buffer.lineAt(static_cast<uint32_t>(token.lexeme.data() - buffer.getSource().data()));
+}
@@ -1,23 +1,22 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include "source_buffer.h"
 #include "lexer.h"
 #include "parser.h"
 #include "ir_generator.h"
+#include "ir_cache.h"
+#include "batch_compiler.h"
 #include "optimizer.h"
 #include "codegen.h"
-
-std::string readFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not open file: " + filename);
-    }
-    
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
-}
+#include "stats.h"
+#include "trace.h"
 
 void writeFile(const std::string& filename, const std::string& content) {
     std::ofstream file(filename);
@@ -27,92 +26,358 @@ void writeFile(const std::string& filename, const std::string& content) {
     file << content;
 }
 
+static size_t countInstructions(const IRModule& module) {
+    size_t count = 0;
+    for (const IRFunction& func : module.functions) {
+        count += func.instructionCount();
+    }
+    return count;
+}
+
+// Lexing through optimization. Returns false after reporting syntax errors.
+static bool buildIR(std::string_view source, bool show_tokens, bool show_ir, bool optimize,
+                    CompileStats* stats, ThreadPool& pool, IRModule& ir_module) {
+    bool measured = ScopedPhase::enabled(stats);
+    // Lexical and syntax analysis run as one pass: the parser pulls
+    // tokens from the lexer on demand
+    std::cout << "=== Lexical Analysis ===\n";
+    if (show_tokens) {
+        Lexer dump_lexer(source);
+        Token token = dump_lexer.getNextToken();
+        while (true) {
+            std::cout << token.toString() << "\n";
+            if (token.type == TokenType::END_OF_FILE) {
+                break;
+            }
+            token = dump_lexer.getNextToken();
+        }
+    }
+    
+    Lexer lexer(source);
+    Parser parser(lexer);
+    // Keep going after a syntax error so one run reports all of them
+    std::vector<std::string> syntax_errors;
+    std::unique_ptr<Program> ast;
+    {
+        // One row: the parser pulls tokens as it goes
+        ScopedPhase phase(stats, "Lexing + parsing", 0, source.size());
+        ast = parser.parse(syntax_errors);
+        phase.setItemsOut(lexer.tokenCount());
+    }
+    if (!syntax_errors.empty()) {
+        for (const std::string& error : syntax_errors) {
+            std::cerr << "Error: " << error << "\n";
+        }
+        return false;
+    }
+    std::cout << "Tokens: " << lexer.tokenCount() << "\n\n";
+    
+    // Syntax analysis
+    std::cout << "=== Syntax Analysis ===\n";
+    std::cout << "Parsing completed successfully\n\n";
+    
+    // Intermediate code generation
+    std::cout << "=== Intermediate Code Generation ===\n";
+    {
+        ScopedPhase phase(stats, "IR generation", 0, lexer.tokenCount());
+        IRGenerator ir_gen;
+        ir_module = ir_gen.generate(ast.get());
+        if (measured) {
+            phase.setItemsOut(countInstructions(ir_module));
+        }
+    }
+    
+    if (show_ir) {
+        std::cout << "Before optimization:\n";
+        std::cout << ir_module.toString();
+    }
+    std::cout << "IR generation completed\n\n";
+    
+    // Optimization
+    if (optimize) {
+        std::cout << "=== Optimization ===\n";
+        {
+            ScopedPhase phase(stats, "Optimization", 0, measured ? countInstructions(ir_module) : 0);
+            Optimizer optimizer;
+            optimizer.setStats(stats);
+            ir_module = optimizer.optimize(ir_module, pool);
+            if (measured) {
+                phase.setItemsOut(countInstructions(ir_module));
+            }
+        }
+        if (show_ir) {
+            std::cout << "After optimization:\n";
+            std::cout << ir_module.toString();
+        }
+        std::cout << "Optimization completed\n\n";
+    }
+    return true;
+}
+
+// Several translation units in one process; see BatchCompiler
+static int compileBatch(const std::vector<std::string>& inputs, const std::string& output_dir, bool optimize,
+                        ThreadPool& pool, IRCache* cache, CompileStats* stats) {
+    std::vector<BatchCompiler::Unit> units(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        units[i].input = inputs[i];
+        units[i].output = BatchCompiler::outputPath(inputs[i], output_dir);
+    }
+    if (!output_dir.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(output_dir, error);
+    }
+    
+    BatchCompiler compiler(pool, optimize);
+    compiler.setCache(cache);
+    compiler.setStats(stats);
+    size_t failed;
+    {
+        TraceScope trace("compileBatch");
+        trace.arg("files", static_cast<long long>(units.size()));
+        failed = compiler.compile(units);
+    }
+    
+    // In input order, whichever thread compiled the unit
+    for (const BatchCompiler::Unit& unit : units) {
+        for (const std::string& error : unit.errors) {
+            std::cerr << "Error: " << unit.input << ": " << error << "\n";
+        }
+    }
+    std::cout << "Compiled " << units.size() - failed << " of " << units.size() << " files\n";
+    return failed == 0 ? 0 : 1;
+}
+
+// Trace file and statistics, once compilation has finished
+static void writeReports(Tracer* tracer, const std::string& trace_file, bool time_report, bool stats_json,
+                         CompileStats* stats) {
+    if (tracer) {
+        Tracer::install(nullptr);
+        std::ostringstream trace;
+        tracer->write(trace);
+        writeFile(trace_file, trace.str());
+    }
+    if (time_report) {
+        stats->printTable(std::cerr);
+    }
+    if (stats_json) {
+        stats->printJSON(std::cerr);
+    }
+}
+
+// Writes the trace file and statistics when it goes out of scope, so
+// failed compilations are reported too
+class ReportWriter {
+private:
+    Tracer* tracer;
+    const std::string& trace_file;
+    bool time_report;
+    bool stats_json;
+    CompileStats* stats;
+
+public:
+    ReportWriter(Tracer* tracer, const std::string& trace_file, bool time_report, bool stats_json,
+                 CompileStats* stats)
+        : tracer(tracer), trace_file(trace_file), time_report(time_report), stats_json(stats_json),
+          stats(stats) {}
+    ~ReportWriter() {
+        try {
+            writeReports(tracer, trace_file, time_report, stats_json, stats);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+    }
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+};
+
+// More threads than this only add scheduling overhead
+static constexpr size_t MAX_JOBS = 256;
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         std::cerr << "Usage: " << argv[0] << " <input.sy> [-o output.s] [-ir] [-tokens]\n";
+        std::cerr << "       " << argv[0] << " <input.sy>... | @filelist [-d dir] [-j n]\n";
         std::cerr << "Options:\n";
-        std::cerr << "  -o <file>   Specify output assembly file (default: a.s)\n";
-        std::cerr << "  -ir         Output intermediate representation\n";
-        std::cerr << "  -tokens     Output tokens from lexical analysis\n";
-        std::cerr << "  -O0         Disable optimizations\n";
+        std::cerr << "  -o <file>          Specify output assembly file (default: a.s)\n";
+        std::cerr << "  -ir                Output intermediate representation\n";
+        std::cerr << "  -tokens            Output tokens from lexical analysis\n";
+        std::cerr << "  -O0                Disable optimizations\n";
+        std::cerr << "  -cache-dir <dir>   Reuse optimized IR of unchanged inputs from <dir>\n";
+        std::cerr << "                     (default: $SYSYC_CACHE_DIR; no cache if unset)\n";
+        std::cerr << "  -ftime-report      Print time, instruction counts and peak memory per phase\n";
+        std::cerr << "                     and optimizer pass to stderr\n";
+        std::cerr << "  -stats             Print the same statistics to stderr as JSON\n";
+        std::cerr << "  -ftrace=<file>     Write a Chrome trace-event timeline of the compilation\n";
+        std::cerr << "  -j <n>             Use <n> threads: functions optimized and generated at a\n";
+        std::cerr << "                     time for one input, files compiled at a time in batch mode\n";
+        std::cerr << "                     (0: one per hardware thread; default: 1)\n";
+        std::cerr << "Batch mode (several inputs, or @filelist with one path per line):\n";
+        std::cerr << "  -d <dir>           Write each <name>.s to <dir> (default: next to its input)\n";
         return 1;
     }
     
-    std::string input_file = argv[1];
+    std::vector<std::string> inputs;
     std::string output_file = "a.s";
+    bool output_set = false;
+    std::string output_dir;
+    bool batch = false;
+    std::vector<std::string> file_lists;
     bool show_ir = false;
     bool show_tokens = false;
     bool optimize = true;
+    const char* cache_env = std::getenv("SYSYC_CACHE_DIR");
+    std::string cache_dir = cache_env ? cache_env : "";
+    bool time_report = false;
+    bool stats_json = false;
+    std::string trace_file;
+    size_t jobs = 1;
     
     // Parse command line arguments
-    for (int i = 2; i < argc; i++) {
+    for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
         if (arg == "-o" && i + 1 < argc) {
             output_file = argv[++i];
+            output_set = true;
+        } else if (arg == "-d" && i + 1 < argc) {
+            output_dir = argv[++i];
+            batch = true;
+        } else if (arg[0] == '@') {
+            file_lists.push_back(arg.substr(1));
+            batch = true;
+        } else if (arg[0] != '-') {
+            inputs.push_back(arg);
         } else if (arg == "-ir") {
             show_ir = true;
         } else if (arg == "-tokens") {
             show_tokens = true;
         } else if (arg == "-O0") {
             optimize = false;
+        } else if (arg == "-cache-dir" && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (arg == "-ftime-report") {
+            time_report = true;
+        } else if (arg == "-stats") {
+            stats_json = true;
+        } else if (arg.compare(0, 8, "-ftrace=") == 0) {
+            trace_file = arg.substr(8);
+        } else if (arg == "-j" && i + 1 < argc) {
+            const char* value = argv[++i];
+            char* end = nullptr;
+            errno = 0;
+            long parsed = std::strtol(value, &end, 10);
+            if (end == value || *end != '\0' || errno == ERANGE || parsed < 0) {
+                std::cerr << "Error: -j expects a thread count of 0 or more, got '" << value << "'\n";
+                return 1;
+            }
+            jobs = std::min(static_cast<size_t>(parsed), MAX_JOBS);
         }
     }
     
     try {
-        // Read source file
-        std::string source = readFile(input_file);
-        
-        // Lexical analysis
-        std::cout << "=== Lexical Analysis ===\n";
-        Lexer lexer(source);
-        std::vector<Token> tokens = lexer.tokenize();
+        for (const std::string& list : file_lists) {
+            std::vector<std::string> listed = BatchCompiler::readFileList(list);
+            inputs.insert(inputs.end(), listed.begin(), listed.end());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    batch = batch || inputs.size() > 1;
+    if (inputs.empty()) {
+        std::cerr << "Error: no input files\n";
+        return 1;
+    }
+    if (batch && (output_set || show_ir || show_tokens)) {
+        std::cerr << "Error: -o, -ir and -tokens take a single input; use -d with several\n";
+        return 1;
+    }
+    const std::string& input_file = inputs[0];
+    
+    // Dumps need the front end to run, so they bypass the cache
+    std::unique_ptr<IRCache> cache;
+    if (!cache_dir.empty() && !show_ir && !show_tokens) {
+        cache = std::make_unique<IRCache>(cache_dir);
+    }
+    // Flags that change the cached IR
+    const std::string ir_flags = optimize ? "-O1" : "-O0";
+    // Only allocated when asked for: every hook checks for null
+    std::unique_ptr<CompileStats> stats;
+    if (time_report || stats_json) {
+        stats = std::make_unique<CompileStats>();
+    }
+    std::unique_ptr<Tracer> tracer;
+    if (!trace_file.empty()) {
+        tracer = std::make_unique<Tracer>();
+        tracer->nameThread("main");
+        Tracer::install(tracer.get());
+    }
+    bool measured = ScopedPhase::enabled(stats.get());
+    // Declared before the spans below, so they have ended when it writes
+    ReportWriter reports(tracer.get(), trace_file, time_report, stats_json, stats.get());
+    try {
+        // Output does not depend on the number of threads
+        ThreadPool pool(jobs);
         
-        if (show_tokens) {
-            for (const auto& token : tokens) {
-                std::cout << token.toString() << "\n";
+        if (batch) {
+            int status = compileBatch(inputs, output_dir, optimize, pool, cache.get(), stats.get());
+            if (cache) {
+                cache->printStats(std::cerr);
             }
+            return status;
         }
-        std::cout << "Tokens: " << tokens.size() << "\n\n";
         
-        // Syntax analysis
-        std::cout << "=== Syntax Analysis ===\n";
-        Parser parser(tokens);
-        auto ast = parser.parse();
-        std::cout << "Parsing completed successfully\n\n";
+        TraceScope compile("compile");
+        compile.arg("file", input_file);
         
-        // Intermediate code generation
-        std::cout << "=== Intermediate Code Generation ===\n";
-        IRGenerator ir_gen;
-        IRModule ir_module = ir_gen.generate(ast.get());
+        // Map source file
+        SourceBuffer source(input_file);
         
-        if (show_ir) {
-            std::cout << "Before optimization:\n";
-            std::cout << ir_module.toString();
+        IRModule ir_module;
+        bool cached = false;
+        if (cache) {
+            ScopedPhase phase(stats.get(), "IR cache lookup", 0, source.view().size());
+            cached = cache->load(source.view(), ir_flags, ir_module);
+            if (measured) {
+                phase.setItemsOut(countInstructions(ir_module));
+            }
         }
-        std::cout << "IR generation completed\n\n";
-        
-        // Optimization
-        if (optimize) {
-            std::cout << "=== Optimization ===\n";
-            Optimizer optimizer;
-            ir_module = optimizer.optimize(ir_module);
-            if (show_ir) {
-                std::cout << "After optimization:\n";
-                std::cout << ir_module.toString();
+        if (cached) {
+            std::cout << "=== IR Cache ===\n";
+            std::cout << "Loaded IR from cache\n\n";
+        } else {
+            if (!buildIR(source.view(), show_tokens, show_ir, optimize, stats.get(), pool, ir_module)) {
+                return 1;
+            }
+            if (cache) {
+                ScopedPhase phase(stats.get(), "IR cache store");
+                if (measured) {
+                    phase.setItemsIn(countInstructions(ir_module));
+                }
+                cache->store(source.view(), ir_flags, ir_module);
             }
-            std::cout << "Optimization completed\n\n";
         }
         
         // Code generation
         std::cout << "=== Code Generation ===\n";
-        CodeGenerator codegen;
-        std::string assembly = codegen.generate(ir_module);
+        std::string assembly;
+        {
+            ScopedPhase phase(stats.get(), "Code generation");
+            if (measured) {
+                phase.setItemsIn(countInstructions(ir_module));
+            }
+            CodeGenerator codegen;
+            assembly = codegen.generate(ir_module, pool);
+            phase.setItemsOut(assembly.size());
+        }
         
         // Write output
         writeFile(output_file, assembly);
         std::cout << "Assembly code written to " << output_file << "\n";
         
         std::cout << "\nCompilation successful!\n";
+        if (cache) {
+            cache->printStats(std::cerr);
+        }
         return 0;
         
     } catch (const std::exception& e) {
@@ -1,14 +1,36 @@
 #include "optimizer.h"
 #include <algorithm>
+#include "ssa.h"
+#include "trace.h"
 
-Optimizer::Optimizer() {}
+Optimizer::Optimizer() : stats(nullptr) {
+    passes.addPass("unreachable", ANALYSIS_NONE, ANALYSIS_NONE, removeUnreachableCode);
+    passes.addPass("mem2reg", ANALYSIS_DOMINATORS, ANALYSIS_DOMINATORS | ANALYSIS_LOOPS, promoteToSSA);
+    passes.addSparsePass("constfold", ANALYSIS_NONE, ANALYSIS_ALL, constantFolding);
+    passes.addSparsePass("constprop", ANALYSIS_DEF_USE, ANALYSIS_ALL, constantPropagation);
+    passes.addSparsePass("dce", ANALYSIS_DEF_USE, ANALYSIS_ALL, deadCodeElimination);
+}
+
+void Optimizer::setStats(CompileStats* stats) {
+    this->stats = stats;
+    passes.setStats(stats, 1);
+}
 
 IRModule Optimizer::optimize(const IRModule& module) {
-    IRModule optimized_module;
-    optimized_module.global_vars = module.global_vars;
-    
-    for (const auto& func : module.functions) {
-        optimized_module.functions.push_back(optimizeFunction(func));
+    ThreadPool inline_pool(1);
+    return optimize(module, inline_pool);
+}
+
+IRModule Optimizer::optimize(const IRModule& module, ThreadPool& pool) {
+    IRModule optimized_module = module;
+    std::vector<IRFunction>& functions = optimized_module.functions;
+    if (pool.size() == 1) {
+        for (IRFunction& func : functions) {
+            runPipeline(func);
+        }
+    } else {
+        std::vector<size_t> order = optimized_module.largestFirst();
+        pool.parallelFor(order.size(), [&](size_t i) { runPipeline(functions[order[i]]); });
     }
     
     return optimized_module;
@@ -16,160 +38,144 @@ IRModule Optimizer::optimize(const IRModule& module) {
 
 IRFunction Optimizer::optimizeFunction(const IRFunction& func) {
     IRFunction optimized = func;
-    
-    bool changed = true;
-    int iterations = 0;
-    const int max_iterations = 10;
-    
-    // Iterate until no more changes or max iterations
-    while (changed && iterations < max_iterations) {
-        changed = false;
-        changed |= constantFolding(optimized);
-        changed |= constantPropagation(optimized);
-        changed |= deadCodeElimination(optimized);
-        iterations++;
-    }
-    
+    runPipeline(optimized);
     return optimized;
 }
 
-bool Optimizer::constantFolding(IRFunction& func) {
-    bool changed = false;
-    std::vector<IRInstruction> new_instructions;
-    
-    for (auto& instr : func.instructions) {
-        // Try to fold binary operations with constant operands
-        if (instr.opcode == IROpcode::ADD || instr.opcode == IROpcode::SUB ||
-            instr.opcode == IROpcode::MUL || instr.opcode == IROpcode::DIV ||
-            instr.opcode == IROpcode::MOD) {
-            
-            // Check if both operands are constants (start with digit or minus)
-            bool arg1_is_const = !instr.arg1.empty() && 
-                                 (std::isdigit(instr.arg1[0]) || instr.arg1[0] == '-');
-            bool arg2_is_const = !instr.arg2.empty() && 
-                                 (std::isdigit(instr.arg2[0]) || instr.arg2[0] == '-');
-            
-            if (arg1_is_const && arg2_is_const) {
-                int val1 = std::stoi(instr.arg1);
-                int val2 = std::stoi(instr.arg2);
-                int result = 0;
-                
-                switch (instr.opcode) {
-                    case IROpcode::ADD: result = val1 + val2; break;
-                    case IROpcode::SUB: result = val1 - val2; break;
-                    case IROpcode::MUL: result = val1 * val2; break;
-                    case IROpcode::DIV: 
-                        if (val2 != 0) result = val1 / val2; 
-                        else goto keep_instruction;
-                        break;
-                    case IROpcode::MOD: 
-                        if (val2 != 0) result = val1 % val2;
-                        else goto keep_instruction;
-                        break;
-                    default: break;
-                }
-                
-                // Replace with constant assignment
-                IRInstruction new_instr(IROpcode::CONST, instr.result, std::to_string(result));
-                new_instructions.push_back(new_instr);
-                changed = true;
-                continue;
-            }
-        }
-        
-        keep_instruction:
-        new_instructions.push_back(instr);
+void Optimizer::runPipeline(IRFunction& func) {
+    TraceScope trace("optimizeFunction");
+    if (trace.active()) {
+        trace.arg("function", func.name.toString());
+        trace.arg("instructions", static_cast<long long>(func.instructions.size()));
     }
-    
-    func.instructions = new_instructions;
-    return changed;
+    bool measured = ScopedPhase::enabled(stats);
+    {
+        ScopedPhase phase(stats, "cfg", 1, func.instructions.size());
+        func.buildCFG();
+        phase.setItemsOut(func.instructionCount());
+    }
+    passes.run(func);
+    {
+        ScopedPhase phase(stats, "out-of-ssa", 1, measured ? func.instructionCount() : 0);
+        destroySSA(func);
+        func.linearize();
+        phase.setItemsOut(func.instructions.size());
+    }
+}
+
+bool Optimizer::removeUnreachableCode(IRFunction& func) {
+    return func.removeUnreachableBlocks();
+}
+
+bool Optimizer::promoteToSSA(IRFunction& func) {
+    return promoteMemoryToRegisters(func);
 }
 
-bool Optimizer::constantPropagation(IRFunction& func) {
-    bool changed = false;
-    std::map<std::string, std::string> constants;
-    std::vector<IRInstruction> new_instructions;
+bool Optimizer::constantFolding(IRFunction& func, const WorkItem& item, Worklist& /*worklist*/) {
+    if (item.phi) {
+        return false;
+    }
+    BasicBlock& block = func.blocks[static_cast<size_t>(item.block)];
+    IRInstruction& instr = block.instructions[static_cast<size_t>(item.index)];
+    // Try to fold binary operations with constant operands
+    if (instr.opcode != IROpcode::ADD && instr.opcode != IROpcode::SUB &&
+        instr.opcode != IROpcode::MUL && instr.opcode != IROpcode::DIV &&
+        instr.opcode != IROpcode::MOD) {
+        return false;
+    }
+    // Check if both operands are constants
+    if (!instr.arg1.isImm() || !instr.arg2.isImm()) {
+        return false;
+    }
+    int val1 = instr.arg1.value;
+    int val2 = instr.arg2.value;
+    int result = 0;
     
-    for (auto& instr : func.instructions) {
-        // Track constant assignments
-        if (instr.opcode == IROpcode::CONST) {
-            constants[instr.result] = instr.arg1;
-            new_instructions.push_back(instr);
-            continue;
-        }
-        
-        // Replace uses of constants
-        IRInstruction new_instr = instr;
-        
-        if (constants.find(instr.arg1) != constants.end()) {
-            new_instr.arg1 = constants[instr.arg1];
-            changed = true;
-        }
-        
-        if (constants.find(instr.arg2) != constants.end()) {
-            new_instr.arg2 = constants[instr.arg2];
-            changed = true;
-        }
-        
-        // Clear constants on store (conservative approach)
-        if (instr.opcode == IROpcode::STORE || instr.opcode == IROpcode::CALL) {
-            constants.clear();
-        }
-        
-        new_instructions.push_back(new_instr);
+    switch (instr.opcode) {
+        case IROpcode::ADD: result = val1 + val2; break;
+        case IROpcode::SUB: result = val1 - val2; break;
+        case IROpcode::MUL: result = val1 * val2; break;
+        case IROpcode::DIV: 
+            if (val2 == 0) return false;
+            result = val1 / val2;
+            break;
+        case IROpcode::MOD: 
+            if (val2 == 0) return false;
+            result = val1 % val2;
+            break;
+        default: break;
     }
     
-    func.instructions = new_instructions;
-    return changed;
+    // Replace with constant assignment; the passes after this one see it
+    // on the same visit
+    instr = IRInstruction(IROpcode::CONST, instr.result, Operand::imm(result));
+    return true;
 }
 
-bool Optimizer::deadCodeElimination(IRFunction& func) {
-    bool changed = false;
-    std::set<std::string> used_vars;
-    std::set<std::string> defined_vars;
-    
-    // First pass: collect all used and defined variables
-    for (const auto& instr : func.instructions) {
-        // Add uses
-        if (!instr.arg1.empty() && instr.arg1[0] == 't') {
-            used_vars.insert(instr.arg1);
+bool Optimizer::constantPropagation(IRFunction& func, const WorkItem& item, Worklist& worklist) {
+    if (item.phi) {
+        return false;
+    }
+    // A temporary with a single definition that sets it to a constant can
+    // be replaced by the constant at each of its uses, which may then fold
+    const BasicBlock& block = func.blocks[static_cast<size_t>(item.block)];
+    const IRInstruction& instr = block.instructions[static_cast<size_t>(item.index)];
+    if (instr.opcode != IROpcode::CONST || !instr.arg1.isImm() ||
+        !func.def(instr.result).unique() || func.uses(instr.result).empty()) {
+        return false;
+    }
+    worklist.pushUsers(func, instr.result);
+    func.replaceAllUsesWith(instr.result, instr.arg1);
+    return true;
+}
+
+static bool hasSideEffects(IROpcode opcode) {
+    switch (opcode) {
+        case IROpcode::STORE:
+        case IROpcode::CALL:
+        case IROpcode::RETURN:
+        case IROpcode::JUMP:
+        case IROpcode::BRANCH:
+        case IROpcode::LABEL:
+        case IROpcode::PARAM:
+        case IROpcode::ALLOC:
+        case IROpcode::NOP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool Optimizer::deadCodeElimination(IRFunction& func, const WorkItem& item, Worklist& worklist) {
+    BasicBlock& block = func.blocks[static_cast<size_t>(item.block)];
+    // The erased code may have been the last reader of its operands
+    auto requeue = [&](Operand operand) {
+        if (operand.isTemp() && func.uses(operand).empty()) {
+            worklist.pushDef(func, operand);
         }
-        if (!instr.arg2.empty() && instr.arg2[0] == 't') {
-            used_vars.insert(instr.arg2);
+    };
+    if (item.phi) {
+        const Phi& phi = block.phis[static_cast<size_t>(item.index)];
+        if (!func.def(phi.result).unique() || !func.uses(phi.result).empty()) {
+            return false;
         }
-        
-        // Add definitions
-        if (!instr.result.empty() && instr.result[0] == 't') {
-            defined_vars.insert(instr.result);
+        std::vector<Operand> incoming = phi.incoming;
+        func.erasePhi(item.block, item.index);
+        for (Operand operand : incoming) {
+            requeue(operand);
         }
+        return true;
     }
     
-    // Second pass: remove instructions that define unused temporaries
-    std::vector<IRInstruction> new_instructions;
-    for (const auto& instr : func.instructions) {
-        // Keep instructions with side effects
-        if (instr.opcode == IROpcode::STORE || 
-            instr.opcode == IROpcode::CALL ||
-            instr.opcode == IROpcode::RETURN ||
-            instr.opcode == IROpcode::JUMP ||
-            instr.opcode == IROpcode::BRANCH ||
-            instr.opcode == IROpcode::LABEL ||
-            instr.opcode == IROpcode::PARAM ||
-            instr.opcode == IROpcode::ALLOC) {
-            new_instructions.push_back(instr);
-            continue;
-        }
-        
-        // Keep if result is used
-        if (instr.result.empty() || used_vars.find(instr.result) != used_vars.end()) {
-            new_instructions.push_back(instr);
-        } else {
-            changed = true;
-        }
+    const IRInstruction& instr = block.instructions[static_cast<size_t>(item.index)];
+    if (hasSideEffects(instr.opcode) || !func.def(instr.result).unique() ||
+        !func.uses(instr.result).empty()) {
+        return false;
     }
-    
-    func.instructions = new_instructions;
-    return changed;
+    IRInstruction erased = instr;
+    func.eraseInstruction(item.block, item.index);
+    erased.forEachUse(requeue);
+    return true;
 }
 
 bool Optimizer::commonSubexpressionElimination(IRFunction& func) {
@@ -178,10 +184,10 @@ bool Optimizer::commonSubexpressionElimination(IRFunction& func) {
     return false;
 }
 
-bool Optimizer::isConstant(const std::string& var, const std::map<std::string, int>& constants) {
+bool Optimizer::isConstant(Operand var, const std::map<Operand, int>& constants) {
     return constants.find(var) != constants.end();
 }
 
-int Optimizer::getConstantValue(const std::string& var, const std::map<std::string, int>& constants) {
+int Optimizer::getConstantValue(Operand var, const std::map<Operand, int>& constants) {
     return constants.at(var);
 }
@@ -0,0 +1,170 @@
+#include "pass_manager.h"
+#include <algorithm>
+
+Worklist::Worklist(const IRFunction& func) {
+    size_t total = 0;
+    for (const BasicBlock& block : func.blocks) {
+        phi_base.push_back(total);
+        total += block.phis.size();
+        instr_base.push_back(total);
+        total += block.instructions.size();
+    }
+    queued.assign(total, 0);
+}
+
+size_t Worklist::slot(const WorkItem& item) const {
+    const std::vector<size_t>& base = item.phi ? phi_base : instr_base;
+    return base[static_cast<size_t>(item.block)] + static_cast<size_t>(item.index);
+}
+
+void Worklist::push(const WorkItem& item) {
+    uint8_t& flag = queued[slot(item)];
+    if (!flag) {
+        flag = 1;
+        stack.push_back(item);
+    }
+}
+
+void Worklist::pushDef(const IRFunction& func, Operand temp) {
+    DefSite def = func.def(temp);
+    if (def.unique()) {
+        push({def.block, def.index, def.phi});
+    }
+}
+
+void Worklist::pushUsers(const IRFunction& func, Operand temp) {
+    for (const UseSite& use : func.uses(temp)) {
+        push({use.block, use.index, use.phi});
+    }
+}
+
+WorkItem Worklist::pop() {
+    WorkItem item = stack.back();
+    stack.pop_back();
+    queued[slot(item)] = 0;
+    return item;
+}
+
+PassManager::PassManager() : visit_count(0), stats(nullptr), stats_depth(0) {}
+
+void PassManager::addPass(const std::string& name, unsigned required, unsigned preserved, FunctionPassFn run) {
+    passes.push_back({name, required, preserved, std::move(run), nullptr});
+}
+
+void PassManager::addSparsePass(const std::string& name, unsigned required, unsigned preserved,
+                                SparsePassFn visit) {
+    passes.push_back({name, required, preserved, nullptr, visit});
+}
+
+void PassManager::prepare(IRFunction& func, unsigned required) {
+    if (required & ANALYSIS_DOMINATORS) {
+        func.dominatorTree();
+    }
+    if (required & ANALYSIS_LOOPS) {
+        func.loopInfo();
+    }
+    if ((required & ANALYSIS_DEF_USE) && !func.hasDefUse()) {
+        func.buildDefUse();
+    }
+}
+
+// The CFG analyses are only dropped together, and take the def-use
+// chains with them
+void PassManager::invalidate(IRFunction& func, unsigned preserved) {
+    if ((preserved & (ANALYSIS_DOMINATORS | ANALYSIS_LOOPS)) != (ANALYSIS_DOMINATORS | ANALYSIS_LOOPS)) {
+        func.invalidateAnalyses();
+    } else if (!(preserved & ANALYSIS_DEF_USE)) {
+        func.dropDefUse();
+    }
+}
+
+void PassManager::runSparse(IRFunction& func, size_t first, size_t last) {
+    bool measured = ScopedPhase::enabled(stats);
+    unsigned required = ANALYSIS_NONE;
+    unsigned preserved = ANALYSIS_ALL;
+    std::string name;
+    for (size_t p = first; p < last; p++) {
+        required |= passes[p].required;
+        preserved &= passes[p].preserved;
+        if (measured) {
+            name += (p == first ? "" : "+") + passes[p].name;
+        }
+    }
+    ScopedPhase phase(stats, name, stats_depth, measured ? func.instructionCount() : 0);
+    prepare(func, required);
+
+    Worklist worklist(func);
+    bool changed = false;
+    size_t visits = 0;
+    std::vector<double> wall_ms(stats ? last - first : 0, 0.0);
+    std::vector<size_t> changes(stats ? last - first : 0, 0);
+    auto offer = [&](const WorkItem& item) {
+        visits++;
+        for (size_t p = first; p < last; p++) {
+            if (!stats) {
+                changed |= passes[p].visit(func, item, worklist);
+                continue;
+            }
+            auto start = std::chrono::steady_clock::now();
+            bool visit_changed = passes[p].visit(func, item, worklist);
+            wall_ms[p - first] += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            changes[p - first] += visit_changed;
+            changed |= visit_changed;
+        }
+    };
+    auto visit = [&](const WorkItem& item) {
+        offer(item);
+        while (!worklist.empty()) {
+            offer(worklist.pop());
+        }
+    };
+    for (size_t b = 0; b < func.blocks.size(); b++) {
+        int block = static_cast<int>(b);
+        for (size_t i = 0; i < func.blocks[b].phis.size(); i++) {
+            visit({block, static_cast<int>(i), true});
+        }
+        for (size_t i = 0; i < func.blocks[b].instructions.size(); i++) {
+            visit({block, static_cast<int>(i), false});
+        }
+    }
+    visit_count.fetch_add(visits, std::memory_order_relaxed);
+    if (changed) {
+        invalidate(func, preserved);
+    }
+    func.compact();
+
+    if (measured) {
+        phase.setItemsOut(func.instructionCount());
+    }
+    if (stats) {
+        for (size_t p = first; p < last; p++) {
+            stats->end(stats->begin(passes[p].name, stats_depth + 1), wall_ms[p - first], 0.0,
+                       visits, changes[p - first]);
+        }
+    }
+}
+
+void PassManager::run(IRFunction& func) {
+    bool measured = ScopedPhase::enabled(stats);
+    for (size_t p = 0; p < passes.size();) {
+        if (passes[p].visit) {
+            size_t last = p;
+            while (last < passes.size() && passes[last].visit) {
+                last++;
+            }
+            runSparse(func, p, last);
+            p = last;
+            continue;
+        }
+        ScopedPhase phase(stats, passes[p].name, stats_depth, measured ? func.instructionCount() : 0);
+        prepare(func, passes[p].required);
+        if (passes[p].run(func)) {
+            invalidate(func, passes[p].preserved);
+        }
+        if (measured) {
+            phase.setItemsOut(func.instructionCount());
+        }
+        p++;
+    }
+}
@@ -0,0 +1,323 @@
+#include "ssa.h"
+#include "dominators.h"
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+struct Variable {
+    bool promotable;
+    bool crosses_blocks;        // read somewhere before being written in that block
+    std::vector<int> def_blocks;
+};
+
+// Value of a variable that was never written
+const Operand UNDEFINED = Operand::imm(0);
+
+// Array elements are spelled "a[t3]"; returns the array, or an empty
+// operand for any other name
+Operand indexedArray(Operand operand) {
+    std::string_view text = operand.symbol().str();
+    size_t bracket = text.find('[');
+    if (bracket == std::string_view::npos || bracket == 0) {
+        return Operand();
+    }
+    return Operand::var(Symbol(text.substr(0, bracket)));
+}
+
+}  // namespace
+
+bool promoteMemoryToRegisters(IRFunction& func) {
+    const DominatorTree& dominators = func.dominatorTree();
+    if (dominators.reversePostorder().size() != func.blocks.size()) {
+        return false;
+    }
+
+    // Candidates, in layout order: a scalar ALLOC (size 4) that precedes
+    // every other reference, and after that only STORE targets and LOAD
+    // sources. A second ALLOC of the name (a same-named declaration in an
+    // inner scope) gets a slot of its own, and an indexed access reads the
+    // array's memory; either keeps the variable in memory.
+    std::unordered_map<Operand, int> index;
+    std::vector<Variable> vars;
+    std::unordered_set<Operand> referenced;
+    for (Symbol param : func.params) {
+        referenced.insert(Operand::var(param));
+    }
+    for (const BasicBlock& block : func.blocks) {
+        for (const IRInstruction& instr : block.instructions) {
+            if (instr.opcode == IROpcode::ALLOC && instr.result.isVar()) {
+                auto var = index.find(instr.result);
+                if (var == index.end()) {
+                    bool scalar = instr.arg1 == Operand::imm(4) &&
+                                  referenced.find(instr.result) == referenced.end();
+                    index.emplace(instr.result, static_cast<int>(vars.size()));
+                    vars.push_back({scalar, false, {}});
+                } else {
+                    vars[static_cast<size_t>(var->second)].promotable = false;
+                }
+            }
+            auto check = [&](Operand operand, bool allowed) {
+                if (!operand.isVar()) {
+                    return;
+                }
+                auto var = index.find(operand);
+                if (var == index.end()) {
+                    referenced.insert(operand);
+                    Operand array = indexedArray(operand);
+                    auto indexed = index.find(array);
+                    if (indexed != index.end()) {
+                        vars[static_cast<size_t>(indexed->second)].promotable = false;
+                    } else if (!array.empty()) {
+                        referenced.insert(array);
+                    }
+                } else if (!allowed) {
+                    vars[static_cast<size_t>(var->second)].promotable = false;
+                }
+            };
+            check(instr.result, instr.opcode == IROpcode::ALLOC || instr.opcode == IROpcode::STORE);
+            check(instr.arg1, instr.opcode == IROpcode::LOAD);
+            check(instr.arg2, false);
+        }
+    }
+    auto promoted = [&](Operand operand) {
+        if (!operand.isVar()) {
+            return -1;
+        }
+        auto var = index.find(operand);
+        return var != index.end() && vars[static_cast<size_t>(var->second)].promotable ? var->second : -1;
+    };
+
+    // Definition sites, and which variables are live across blocks
+    bool any = false;
+    std::vector<int> written_in(vars.size(), -1);
+    for (size_t b = 0; b < func.blocks.size(); b++) {
+        for (const IRInstruction& instr : func.blocks[b].instructions) {
+            if (instr.opcode == IROpcode::LOAD) {
+                int var = promoted(instr.arg1);
+                if (var >= 0 && written_in[static_cast<size_t>(var)] != static_cast<int>(b)) {
+                    vars[static_cast<size_t>(var)].crosses_blocks = true;
+                }
+            } else if (instr.opcode == IROpcode::STORE || instr.opcode == IROpcode::ALLOC) {
+                int var = promoted(instr.result);
+                if (var >= 0 && written_in[static_cast<size_t>(var)] != static_cast<int>(b)) {
+                    written_in[static_cast<size_t>(var)] = static_cast<int>(b);
+                    vars[static_cast<size_t>(var)].def_blocks.push_back(static_cast<int>(b));
+                }
+                any |= var >= 0;
+            }
+        }
+    }
+    if (!any) {
+        return false;
+    }
+    func.dropDefUse();
+
+    // Phis at the iterated dominance frontier of each variable's definitions
+    std::vector<std::vector<int>> phi_vars(func.blocks.size());
+    std::vector<int> has_phi(func.blocks.size(), -1);
+    std::vector<int> queued(func.blocks.size(), -1);
+    for (size_t v = 0; v < vars.size(); v++) {
+        const Variable& var = vars[v];
+        if (!var.promotable || !var.crosses_blocks) {
+            continue;
+        }
+        std::vector<int> worklist = var.def_blocks;
+        for (int block : worklist) {
+            queued[static_cast<size_t>(block)] = static_cast<int>(v);
+        }
+        while (!worklist.empty()) {
+            int block = worklist.back();
+            worklist.pop_back();
+            for (int join : dominators.frontier(block)) {
+                if (has_phi[static_cast<size_t>(join)] == static_cast<int>(v)) {
+                    continue;
+                }
+                has_phi[static_cast<size_t>(join)] = static_cast<int>(v);
+                BasicBlock& target = func.blocks[static_cast<size_t>(join)];
+                target.phis.push_back({func.newTemp(), std::vector<Operand>(target.preds.size())});
+                phi_vars[static_cast<size_t>(join)].push_back(static_cast<int>(v));
+                if (queued[static_cast<size_t>(join)] != static_cast<int>(v)) {
+                    queued[static_cast<size_t>(join)] = static_cast<int>(v);
+                    worklist.push_back(join);
+                }
+            }
+        }
+    }
+
+    // Renaming, in dominator tree preorder: each variable's current value
+    // is the top of its stack, and LOAD results are rewritten to it
+    std::vector<std::vector<Operand>> stacks(vars.size());
+    std::vector<Operand> replacement(static_cast<size_t>(func.temp_counter));
+    auto current = [&stacks](int var) {
+        const std::vector<Operand>& stack = stacks[static_cast<size_t>(var)];
+        return stack.empty() ? UNDEFINED : stack.back();
+    };
+    auto resolve = [&replacement](Operand& operand) {
+        if (operand.isTemp() && static_cast<size_t>(operand.value) < replacement.size() &&
+            !replacement[static_cast<size_t>(operand.value)].empty()) {
+            operand = replacement[static_cast<size_t>(operand.value)];
+        }
+    };
+    struct Visit {
+        int block;
+        bool entered;
+        std::vector<int> pushed;    // variables to pop on the way out
+    };
+    std::vector<Visit> walk = {{0, false, {}}};
+    while (!walk.empty()) {
+        if (walk.back().entered) {
+            for (int var : walk.back().pushed) {
+                stacks[static_cast<size_t>(var)].pop_back();
+            }
+            walk.pop_back();
+            continue;
+        }
+        walk.back().entered = true;
+        int b = walk.back().block;
+        std::vector<int> pushed;
+        BasicBlock& block = func.blocks[static_cast<size_t>(b)];
+        size_t first_new_phi = block.phis.size() - phi_vars[static_cast<size_t>(b)].size();
+        for (size_t i = 0; i < phi_vars[static_cast<size_t>(b)].size(); i++) {
+            int var = phi_vars[static_cast<size_t>(b)][i];
+            stacks[static_cast<size_t>(var)].push_back(block.phis[first_new_phi + i].result);
+            pushed.push_back(var);
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < block.instructions.size(); i++) {
+            IRInstruction instr = block.instructions[i];
+            instr.forEachUse(resolve);
+            if (instr.opcode == IROpcode::ALLOC || instr.opcode == IROpcode::STORE) {
+                int var = promoted(instr.result);
+                if (var >= 0) {
+                    stacks[static_cast<size_t>(var)].push_back(
+                        instr.opcode == IROpcode::STORE ? instr.arg1 : UNDEFINED);
+                    pushed.push_back(var);
+                    continue;
+                }
+            } else if (instr.opcode == IROpcode::LOAD && instr.result.isTemp()) {
+                int var = promoted(instr.arg1);
+                if (var >= 0) {
+                    replacement[static_cast<size_t>(instr.result.value)] = current(var);
+                    continue;
+                }
+            }
+            block.instructions[kept++] = instr;
+        }
+        block.instructions.erase(block.instructions.begin() + static_cast<std::ptrdiff_t>(kept),
+                                 block.instructions.end());
+
+        for (int succ : block.succs) {
+            BasicBlock& target = func.blocks[static_cast<size_t>(succ)];
+            size_t pred = 0;
+            while (target.preds[pred] != b) {
+                pred++;
+            }
+            const std::vector<int>& vars_here = phi_vars[static_cast<size_t>(succ)];
+            size_t first = target.phis.size() - vars_here.size();
+            for (size_t i = 0; i < vars_here.size(); i++) {
+                target.phis[first + i].incoming[pred] = current(vars_here[i]);
+            }
+        }
+        walk.back().pushed = std::move(pushed);
+        for (int child : dominators.children(b)) {
+            walk.push_back({child, false, {}});
+        }
+    }
+    return true;
+}
+
+// Orders the copies of one edge so that none overwrites a value another
+// still has to read; a cycle is broken by saving one destination first
+static void sequentializeCopies(IRFunction& func, std::vector<std::pair<Operand, Operand>> copies,
+                                std::vector<IRInstruction>& out) {
+    size_t kept = 0;
+    for (const auto& copy : copies) {
+        if (copy.first != copy.second) {
+            copies[kept++] = copy;
+        }
+    }
+    copies.resize(kept);
+    while (!copies.empty()) {
+        bool emitted = false;
+        for (size_t i = 0; i < copies.size() && !emitted; i++) {
+            bool still_read = false;
+            for (const auto& other : copies) {
+                still_read |= other.second == copies[i].first;
+            }
+            if (!still_read) {
+                out.emplace_back(IROpcode::MOVE, copies[i].first, copies[i].second);
+                copies.erase(copies.begin() + static_cast<std::ptrdiff_t>(i));
+                emitted = true;
+            }
+        }
+        if (!emitted) {
+            Operand saved = func.newTemp();
+            Operand overwritten = copies.front().first;
+            out.emplace_back(IROpcode::MOVE, saved, overwritten);
+            for (auto& copy : copies) {
+                if (copy.second == overwritten) {
+                    copy.second = saved;
+                }
+            }
+        }
+    }
+}
+
+void destroySSA(IRFunction& func) {
+    func.dropDefUse();
+    size_t block_count = func.blocks.size();
+    for (size_t b = 0; b < block_count; b++) {
+        if (func.blocks[b].phis.empty()) {
+            continue;
+        }
+        for (size_t j = 0; j < func.blocks[b].preds.size(); j++) {
+            std::vector<std::pair<Operand, Operand>> copies;
+            for (const Phi& phi : func.blocks[b].phis) {
+                copies.emplace_back(phi.result, phi.incoming[j]);
+            }
+            std::vector<IRInstruction> moves;
+            sequentializeCopies(func, std::move(copies), moves);
+            if (moves.empty()) {
+                continue;
+            }
+
+            int pred = func.blocks[b].preds[j];
+            const IRInstruction* last = func.blocks[static_cast<size_t>(pred)].terminator();
+            if (last && last->opcode == IROpcode::BRANCH) {
+                // The branch may read a value the copies overwrite, and its
+                // other target must not see them: copy on a new block
+                int split = func.addBlock();
+                BasicBlock& target = func.blocks[b];
+                BasicBlock& middle = func.blocks[static_cast<size_t>(split)];
+                BasicBlock& source = func.blocks[static_cast<size_t>(pred)];
+                middle.instructions.insert(middle.instructions.end(), moves.begin(), moves.end());
+                middle.instructions.emplace_back(IROpcode::JUMP, target.label);
+                IRInstruction& branch = source.instructions.back();
+                if (branch.result == target.label) {
+                    branch.result = middle.label;
+                }
+                if (branch.arg2 == target.label) {
+                    branch.arg2 = middle.label;
+                }
+                for (int& succ : source.succs) {
+                    if (succ == static_cast<int>(b)) {
+                        succ = split;
+                    }
+                }
+                target.preds[j] = split;
+                middle.preds.push_back(pred);
+                middle.succs.push_back(static_cast<int>(b));
+            } else {
+                std::vector<IRInstruction>& instructions = func.blocks[static_cast<size_t>(pred)].instructions;
+                instructions.insert(instructions.end() - (last ? 1 : 0), moves.begin(), moves.end());
+            }
+        }
+    }
+    for (BasicBlock& block : func.blocks) {
+        block.phis.clear();
+    }
+}
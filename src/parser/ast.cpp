@@ -1,4 +1,14 @@
 #include "ast.h"
+#include <type_traits>
+
+// Nodes are never destroyed individually (see ASTNode)
+template <typename... Nodes>
+constexpr bool triviallyDestructible = (std::is_trivially_destructible<Nodes>::value && ...);
+static_assert(triviallyDestructible<IntLiteralExpr, CharLiteralExpr, StringLiteralExpr, IdentExpr,
+                                    BinaryExpr, UnaryExpr, CallExpr, ArrayAccess, ExprStmt, Block,
+                                    IfStmt, WhileStmt, ReturnStmt, BreakStmt, ContinueStmt,
+                                    VarDecl, FunctionDef>,
+              "AST nodes must not need destructors");
 
 // IntLiteralExpr
 IntLiteralExpr::IntLiteralExpr(int value) : value(value) {
@@ -19,7 +29,7 @@ void CharLiteralExpr::accept(ASTVisitor* visitor) {
 }
 
 // StringLiteralExpr
-StringLiteralExpr::StringLiteralExpr(const std::string& value) : value(value) {
+StringLiteralExpr::StringLiteralExpr(std::string_view value) : value(value) {
     type = ASTNodeType::STRING_LITERAL_EXPR;
 }
 
@@ -28,7 +38,7 @@ void StringLiteralExpr::accept(ASTVisitor* visitor) {
 }
 
 // IdentExpr
-IdentExpr::IdentExpr(const std::string& name) : name(name) {
+IdentExpr::IdentExpr(Symbol name) : name(name) {
     type = ASTNodeType::IDENT_EXPR;
 }
 
@@ -37,9 +47,8 @@ void IdentExpr::accept(ASTVisitor* visitor) {
 }
 
 // BinaryExpr
-BinaryExpr::BinaryExpr(const std::string& op, std::unique_ptr<Expression> left,
-                       std::unique_ptr<Expression> right)
-    : op(op), left(std::move(left)), right(std::move(right)) {
+BinaryExpr::BinaryExpr(BinaryOp op, Expression* left, Expression* right)
+    : op(op), left(left), right(right) {
     type = ASTNodeType::BINARY_EXPR;
 }
 
@@ -48,8 +57,8 @@ void BinaryExpr::accept(ASTVisitor* visitor) {
 }
 
 // UnaryExpr
-UnaryExpr::UnaryExpr(const std::string& op, std::unique_ptr<Expression> operand)
-    : op(op), operand(std::move(operand)) {
+UnaryExpr::UnaryExpr(UnaryOp op, Expression* operand)
+    : op(op), operand(operand) {
     type = ASTNodeType::UNARY_EXPR;
 }
 
@@ -58,7 +67,7 @@ void UnaryExpr::accept(ASTVisitor* visitor) {
 }
 
 // CallExpr
-CallExpr::CallExpr(const std::string& func_name) : func_name(func_name) {
+CallExpr::CallExpr(Symbol func_name) : func_name(func_name) {
     type = ASTNodeType::CALL_EXPR;
 }
 
@@ -67,8 +76,8 @@ void CallExpr::accept(ASTVisitor* visitor) {
 }
 
 // ArrayAccess
-ArrayAccess::ArrayAccess(const std::string& array_name, std::unique_ptr<Expression> index)
-    : array_name(array_name), index(std::move(index)) {
+ArrayAccess::ArrayAccess(Symbol array_name, Expression* index)
+    : array_name(array_name), index(index) {
     type = ASTNodeType::ARRAY_ACCESS;
 }
 
@@ -77,7 +86,7 @@ void ArrayAccess::accept(ASTVisitor* visitor) {
 }
 
 // ExprStmt
-ExprStmt::ExprStmt(std::unique_ptr<Expression> expr) : expr(std::move(expr)) {
+ExprStmt::ExprStmt(Expression* expr) : expr(expr) {
     type = ASTNodeType::EXPR_STMT;
 }
 
@@ -86,16 +95,19 @@ void ExprStmt::accept(ASTVisitor* visitor) {
 }
 
 // Block
-void Block::accept(ASTVisitor* visitor) {
+Block::Block() {
     type = ASTNodeType::BLOCK;
+}
+
+void Block::accept(ASTVisitor* visitor) {
     visitor->visit(this);
 }
 
 // IfStmt
-IfStmt::IfStmt(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> then_stmt,
-               std::unique_ptr<Statement> else_stmt)
-    : condition(std::move(condition)), then_stmt(std::move(then_stmt)), 
-      else_stmt(std::move(else_stmt)) {
+IfStmt::IfStmt(Expression* condition, Statement* then_stmt,
+               Statement* else_stmt)
+    : condition(condition), then_stmt(then_stmt), 
+      else_stmt(else_stmt) {
     type = ASTNodeType::IF_STMT;
 }
 
@@ -104,8 +116,8 @@ void IfStmt::accept(ASTVisitor* visitor) {
 }
 
 // WhileStmt
-WhileStmt::WhileStmt(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> body)
-    : condition(std::move(condition)), body(std::move(body)) {
+WhileStmt::WhileStmt(Expression* condition, Statement* body)
+    : condition(condition), body(body) {
     type = ASTNodeType::WHILE_STMT;
 }
 
@@ -114,7 +126,7 @@ void WhileStmt::accept(ASTVisitor* visitor) {
 }
 
 // ReturnStmt
-ReturnStmt::ReturnStmt(std::unique_ptr<Expression> value) : value(std::move(value)) {
+ReturnStmt::ReturnStmt(Expression* value) : value(value) {
     type = ASTNodeType::RETURN_STMT;
 }
 
@@ -123,23 +135,29 @@ void ReturnStmt::accept(ASTVisitor* visitor) {
 }
 
 // BreakStmt
-void BreakStmt::accept(ASTVisitor* visitor) {
+BreakStmt::BreakStmt() {
     type = ASTNodeType::BREAK_STMT;
+}
+
+void BreakStmt::accept(ASTVisitor* visitor) {
     visitor->visit(this);
 }
 
 // ContinueStmt
-void ContinueStmt::accept(ASTVisitor* visitor) {
+ContinueStmt::ContinueStmt() {
     type = ASTNodeType::CONTINUE_STMT;
+}
+
+void ContinueStmt::accept(ASTVisitor* visitor) {
     visitor->visit(this);
 }
 
 // VarDecl
-VarDecl::VarDecl(const std::string& name, const std::string& var_type, bool is_const, 
+VarDecl::VarDecl(Symbol name, std::string_view var_type, bool is_const, 
                  bool is_array, int array_size, int pointer_level,
-                 std::unique_ptr<Expression> init_value)
+                 Expression* init_value)
     : name(name), var_type(var_type), is_const(is_const), is_array(is_array), 
-      array_size(array_size), pointer_level(pointer_level), init_value(std::move(init_value)) {
+      array_size(array_size), pointer_level(pointer_level), init_value(init_value) {
     type = ASTNodeType::VAR_DECL;
 }
 
@@ -148,8 +166,8 @@ void VarDecl::accept(ASTVisitor* visitor) {
 }
 
 // FunctionDef
-FunctionDef::FunctionDef(const std::string& name, const std::string& return_type)
-    : name(name), return_type(return_type) {
+FunctionDef::FunctionDef(Symbol name, std::string_view return_type)
+    : name(name), return_type(return_type), body(nullptr) {
     type = ASTNodeType::FUNCTION_DEF;
 }
 
@@ -158,7 +176,10 @@ void FunctionDef::accept(ASTVisitor* visitor) {
 }
 
 // Program
-void Program::accept(ASTVisitor* visitor) {
+Program::Program() {
     type = ASTNodeType::PROGRAM;
+}
+
+void Program::accept(ASTVisitor* visitor) {
     visitor->visit(this);
 }
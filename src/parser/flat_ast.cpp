@@ -0,0 +1,161 @@
+#include "flat_ast.h"
+#include <stdexcept>
+
+uint32_t FlatAST::add(const FlatNode& node) {
+    nodes.push_back(node);
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+uint32_t FlatAST::addString(std::string_view text) {
+    strings.push_back(text);
+    return static_cast<uint32_t>(strings.size() - 1);
+}
+
+FlatAST FlatAST::build(const Program& program) {
+    FlatAST flat;
+    flat.nodes.push_back(FlatNode{ASTNodeType::PROGRAM, 0, Symbol(), 0, 0, 0, 0});
+    flat.declarations.reserve(program.declarations.size());
+    for (const ASTNode* decl : program.declarations) {
+        flat.declarations.push_back(flat.flatten(decl));
+    }
+    return flat;
+}
+
+// A node is added before its children, and only the slots it owns are
+// patched afterwards: `nodes` may reallocate while the children are added.
+uint32_t FlatAST::flatten(const ASTNode* node) {
+    if (!node) {
+        return 0;
+    }
+
+    FlatNode flat{node->type, 0, Symbol(), 0, 0, 0, 0};
+    switch (node->type) {
+        case ASTNodeType::INT_LITERAL_EXPR:
+            flat.value = static_cast<const IntLiteralExpr*>(node)->value;
+            return add(flat);
+        case ASTNodeType::CHAR_LITERAL_EXPR:
+            flat.value = static_cast<const CharLiteralExpr*>(node)->value;
+            return add(flat);
+        case ASTNodeType::STRING_LITERAL_EXPR:
+            flat.a = addString(static_cast<const StringLiteralExpr*>(node)->value);
+            return add(flat);
+        case ASTNodeType::IDENT_EXPR:
+            flat.name = static_cast<const IdentExpr*>(node)->name;
+            return add(flat);
+        case ASTNodeType::BREAK_STMT:
+        case ASTNodeType::CONTINUE_STMT:
+            return add(flat);
+
+        case ASTNodeType::BINARY_EXPR: {
+            auto* binary = static_cast<const BinaryExpr*>(node);
+            flat.op = static_cast<uint8_t>(binary->op);
+            uint32_t index = add(flat);
+            uint32_t left = flatten(binary->left);
+            uint32_t right = flatten(binary->right);
+            nodes[index].a = left;
+            nodes[index].b = right;
+            return index;
+        }
+        case ASTNodeType::UNARY_EXPR: {
+            auto* unary = static_cast<const UnaryExpr*>(node);
+            flat.op = static_cast<uint8_t>(unary->op);
+            uint32_t index = add(flat);
+            uint32_t operand = flatten(unary->operand);
+            nodes[index].a = operand;
+            return index;
+        }
+        case ASTNodeType::ARRAY_ACCESS: {
+            auto* access = static_cast<const ArrayAccess*>(node);
+            flat.name = access->array_name;
+            uint32_t index = add(flat);
+            uint32_t subscript = flatten(access->index);
+            nodes[index].a = subscript;
+            return index;
+        }
+        case ASTNodeType::CALL_EXPR: {
+            auto* call = static_cast<const CallExpr*>(node);
+            flat.name = call->func_name;
+            flat.a = static_cast<uint32_t>(lists.size());
+            flat.b = static_cast<uint32_t>(call->args.size());
+            lists.resize(lists.size() + call->args.size());
+            uint32_t index = add(flat);
+            for (size_t i = 0; i < call->args.size(); i++) {
+                uint32_t arg = flatten(call->args[i]);
+                lists[flat.a + i] = arg;
+            }
+            return index;
+        }
+        case ASTNodeType::BLOCK: {
+            auto* block = static_cast<const Block*>(node);
+            flat.a = static_cast<uint32_t>(lists.size());
+            flat.b = static_cast<uint32_t>(block->statements.size());
+            lists.resize(lists.size() + block->statements.size());
+            uint32_t index = add(flat);
+            for (size_t i = 0; i < block->statements.size(); i++) {
+                uint32_t stmt = flatten(block->statements[i]);
+                lists[flat.a + i] = stmt;
+            }
+            return index;
+        }
+
+        case ASTNodeType::EXPR_STMT: {
+            uint32_t index = add(flat);
+            uint32_t expr = flatten(static_cast<const ExprStmt*>(node)->expr);
+            nodes[index].a = expr;
+            return index;
+        }
+        case ASTNodeType::RETURN_STMT: {
+            uint32_t index = add(flat);
+            uint32_t value = flatten(static_cast<const ReturnStmt*>(node)->value);
+            nodes[index].a = value;
+            return index;
+        }
+        case ASTNodeType::IF_STMT: {
+            auto* stmt = static_cast<const IfStmt*>(node);
+            uint32_t index = add(flat);
+            uint32_t condition = flatten(stmt->condition);
+            uint32_t then_stmt = flatten(stmt->then_stmt);
+            uint32_t else_stmt = flatten(stmt->else_stmt);
+            nodes[index].a = condition;
+            nodes[index].b = then_stmt;
+            nodes[index].c = else_stmt;
+            return index;
+        }
+        case ASTNodeType::WHILE_STMT: {
+            auto* stmt = static_cast<const WhileStmt*>(node);
+            uint32_t index = add(flat);
+            uint32_t condition = flatten(stmt->condition);
+            uint32_t body = flatten(stmt->body);
+            nodes[index].a = condition;
+            nodes[index].b = body;
+            return index;
+        }
+        case ASTNodeType::VAR_DECL: {
+            auto* decl = static_cast<const VarDecl*>(node);
+            flat.name = decl->name;
+            flat.op = (decl->is_const ? VAR_CONST : 0) | (decl->is_array ? VAR_ARRAY : 0);
+            flat.value = decl->array_size;
+            flat.b = static_cast<uint32_t>(decl->pointer_level);
+            flat.c = addString(decl->var_type);
+            uint32_t index = add(flat);
+            uint32_t init = flatten(decl->init_value);
+            nodes[index].a = init;
+            return index;
+        }
+        case ASTNodeType::FUNCTION_DEF: {
+            auto* func = static_cast<const FunctionDef*>(node);
+            flat.name = func->name;
+            flat.value = static_cast<int32_t>(addString(func->return_type));
+            flat.a = static_cast<uint32_t>(params.size());
+            flat.b = static_cast<uint32_t>(func->params.size());
+            params.insert(params.end(), func->params.begin(), func->params.end());
+            uint32_t index = add(flat);
+            uint32_t body = flatten(func->body);
+            nodes[index].c = body;
+            return index;
+        }
+
+        default:
+            throw std::runtime_error("Unexpected node in flat AST");
+    }
+}
@@ -0,0 +1,173 @@
+#include "incremental_parser.h"
+#include "lexer.h"
+#include "parser.h"
+#include <cctype>
+#include <stdexcept>
+
+// Whether `text` can be followed by the next segment without either one
+// lexing differently: it must not end inside a comment, and a trailing
+// identifier or number would run into the keyword that starts the next
+// declaration.
+static bool endsBetweenTokens(std::string_view text, const std::vector<Token>& tokens) {
+    size_t trivia = 0;
+    if (tokens.size() > 1) {
+        const Token& last = tokens[tokens.size() - 2];
+        trivia = last.lexeme.data() + last.lexeme.size() - text.data();
+    }
+    if (trivia == text.size()) {
+        unsigned char c = text.empty() ? ' ' : text.back();
+        return !std::isalnum(c) && c != '_';
+    }
+    
+    size_t i = trivia;
+    while (i < text.size()) {
+        if (std::isspace(static_cast<unsigned char>(text[i]))) {
+            i++;
+        } else if (text.compare(i, 2, "//") == 0) {
+            i = text.find('\n', i);
+            if (i == std::string_view::npos) {
+                return false;
+            }
+        } else if (text.compare(i, 2, "/*") == 0) {
+            i = text.find("*/", i + 2);
+            if (i == std::string_view::npos) {
+                return false;
+            }
+            i += 2;
+        } else {
+            // Anything else (a NUL byte) stops the Lexer for the whole file
+            return false;
+        }
+    }
+    return true;
+}
+
+IncrementalParser::IncrementalParser(const std::string& source) : valid(false), reparsed_bytes(0) {
+    parseAll(source);
+}
+
+void IncrementalParser::parseAll(const std::string& source) {
+    reparsed_bytes = source.size();
+    try {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        auto parsed = std::make_unique<Program>();
+        std::vector<size_t> starts;
+        while (!parser.atEnd()) {
+            starts.push_back(parser.nextToken().lexeme.data() - source.data());
+            parsed->declarations.push_back(parser.parseDeclaration(*parsed));
+        }
+        
+        // One segment per declaration; leading trivia goes to the first
+        std::vector<Segment> split;
+        for (size_t i = 0; i < starts.size(); i++) {
+            size_t begin = i == 0 ? 0 : starts[i];
+            size_t end = i + 1 < starts.size() ? starts[i + 1] : source.size();
+            split.push_back(Segment{source.substr(begin, end - begin), 1, nullptr});
+        }
+        if (split.empty()) {
+            split.push_back(Segment{source, 0, nullptr});
+        }
+        segments = std::move(split);
+        program = std::move(parsed);
+        valid = true;
+    } catch (const std::runtime_error&) {
+        // Keep the text so later edits can repair it
+        segments.clear();
+        segments.push_back(Segment{source, 0, nullptr});
+        valid = false;
+        throw;
+    }
+}
+
+// Re-parses the edited `text` that replaces segments [first, last].
+// Returns false if the edit cannot be handled without the rest of the file.
+bool IncrementalParser::reparseSegments(size_t first, size_t last, std::string text) {
+    reparsed_bytes = text.size();
+    Lexer lexer(text);
+    std::vector<Token> tokens;
+    std::unique_ptr<Program> parsed;
+    try {
+        tokens = lexer.tokenize();
+        if (last + 1 < segments.size() && !endsBetweenTokens(text, tokens)) {
+            return false;
+        }
+        parsed = Parser(tokens).parse();
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+    
+    size_t index = 0;
+    for (size_t i = 0; i < first; i++) {
+        index += segments[i].declarations;
+    }
+    size_t replaced = 0;
+    for (size_t i = first; i <= last; i++) {
+        replaced += segments[i].declarations;
+    }
+    
+    auto& declarations = program->declarations;
+    declarations.erase(declarations.begin() + index, declarations.begin() + index + replaced);
+    declarations.insert(declarations.begin() + index,
+                        parsed->declarations.begin(), parsed->declarations.end());
+    
+    // Dropping the replaced segments frees the nodes only they referenced
+    size_t count = parsed->declarations.size();
+    segments.erase(segments.begin() + first + 1, segments.begin() + last + 1);
+    segments[first] = Segment{std::move(text), count, std::move(parsed)};
+    return true;
+}
+
+void IncrementalParser::applyEdit(const TextEdit& edit) {
+    size_t edit_end = edit.offset + edit.length;
+    
+    // Segments overlapping [offset, offset + length]; an edit on a boundary
+    // belongs to the segment before it
+    size_t first = segments.size();
+    size_t last = segments.size();
+    size_t first_start = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        size_t end = start + segments[i].text.size();
+        if (first == segments.size() && edit.offset <= end) {
+            first = i;
+            first_start = start;
+        }
+        if (first != segments.size() && edit_end <= end) {
+            last = i;
+            break;
+        }
+        start = end;
+    }
+    if (last == segments.size()) {
+        throw std::out_of_range("Edit outside the source");
+    }
+    
+    std::string text;
+    for (size_t i = first; i <= last; i++) {
+        text += segments[i].text;
+    }
+    text.replace(edit.offset - first_start, edit.length, edit.text);
+    
+    if (valid && reparseSegments(first, last, text)) {
+        return;
+    }
+    
+    std::string source;
+    for (size_t i = 0; i < first; i++) {
+        source += segments[i].text;
+    }
+    source += text;
+    for (size_t i = last + 1; i < segments.size(); i++) {
+        source += segments[i].text;
+    }
+    parseAll(source);
+}
+
+std::string IncrementalParser::text() const {
+    std::string source;
+    for (const Segment& segment : segments) {
+        source += segment.text;
+    }
+    return source;
+}
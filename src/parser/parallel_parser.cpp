@@ -0,0 +1,143 @@
+#include "parallel_parser.h"
+#include "parser.h"
+#include <algorithm>
+#include <stdexcept>
+
+// Hands out the tokens of a TokenBuffer that fall in a list of index
+// ranges, in order, followed by END_OF_FILE.
+class RangeTokenSource : public TokenSource {
+private:
+    const TokenBuffer& buffer;
+    std::vector<std::pair<size_t, size_t>> ranges;   // [first, last)
+    size_t range;
+    size_t index;
+
+public:
+    RangeTokenSource(const TokenBuffer& buffer, std::vector<std::pair<size_t, size_t>> ranges)
+        : buffer(buffer), ranges(std::move(ranges)), range(0),
+          index(this->ranges.empty() ? 0 : this->ranges[0].first) {}
+
+    Token next() override {
+        while (range < ranges.size() && index >= ranges[range].second) {
+            if (++range < ranges.size()) {
+                index = ranges[range].first;
+            }
+        }
+        if (range == ranges.size()) {
+            return buffer.token(buffer.size() - 1, false);  // Return EOF
+        }
+        return buffer.token(index++, false);
+    }
+    // line() is left at 0: errors are re-reported by the serial parse, and
+    // building the buffer's LineTable from several threads would race
+};
+
+ParallelParser::ParallelParser(const TokenBuffer& tokens, ThreadPool& pool)
+    : tokens(tokens), pool(pool) {}
+
+// Records the outermost brace pairs. Returns false if the braces do not
+// balance, which the serial parser will report.
+bool ParallelParser::findBodies() {
+    bodies.clear();
+    size_t depth = 0;
+    size_t open = 0;
+    for (size_t i = 0; i + 1 < tokens.size(); i++) {
+        TokenType type = tokens.type(i);
+        if (type == TokenType::LBRACE) {
+            if (depth++ == 0) {
+                open = i;
+            }
+        } else if (type == TokenType::RBRACE) {
+            if (depth == 0) {
+                return false;
+            }
+            if (--depth == 0) {
+                bodies.emplace_back(open, i);
+            }
+        }
+    }
+    return depth == 0;
+}
+
+// Declarations with every body cut down to its braces, i.e. parsed as {}
+std::unique_ptr<Program> ParallelParser::parseSkeleton() {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t from = 0;
+    for (const auto& body : bodies) {
+        ranges.emplace_back(from, body.first + 1);
+        from = body.second;
+    }
+    ranges.emplace_back(from, tokens.size() - 1);
+    
+    RangeTokenSource source(tokens, std::move(ranges));
+    Parser parser(source);
+    return parser.parse();
+}
+
+void ParallelParser::parseBodies(Program& program, std::vector<FunctionDef*>& functions) {
+    // Contiguous batches of about equal token count; several per thread
+    // even out bodies of different sizes
+    size_t body_tokens = 0;
+    for (const auto& body : bodies) {
+        body_tokens += body.second - body.first + 1;
+    }
+    size_t batch_count = std::min(bodies.size(), pool.size() * 4);
+    std::vector<size_t> batch_starts{0};
+    size_t seen = 0;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        seen += bodies[i].second - bodies[i].first + 1;
+        if (seen * batch_count >= body_tokens * batch_starts.size() && i + 1 < bodies.size()) {
+            batch_starts.push_back(i + 1);
+        }
+    }
+    batch_starts.push_back(bodies.size());
+    
+    std::vector<Arena> arenas(batch_starts.size() - 1);
+    pool.parallelFor(arenas.size(), [&](size_t batch) {
+        size_t first = batch_starts[batch];
+        size_t last = batch_starts[batch + 1];
+        std::vector<std::pair<size_t, size_t>> ranges;
+        for (size_t i = first; i < last; i++) {
+            ranges.emplace_back(bodies[i].first, bodies[i].second + 1);
+        }
+        
+        RangeTokenSource source(tokens, std::move(ranges));
+        Parser parser(source);
+        for (size_t i = first; i < last; i++) {
+            Block* body = parser.parseBody(arenas[batch]);
+            // Braces balance, so the block must end at the matching '}'
+            const char* next = i + 1 < last ? tokens.lexeme(bodies[i + 1].first).data() : nullptr;
+            if (next ? parser.nextToken().lexeme.data() != next : !parser.atEnd()) {
+                throw ParseError("Function body does not end at its closing brace");
+            }
+            functions[i]->body = body;
+        }
+    });
+    
+    for (Arena& arena : arenas) {
+        program.arena.adopt(arena);
+    }
+}
+
+std::unique_ptr<Program> ParallelParser::parse() {
+    if (pool.size() > 1 && findBodies() && bodies.size() > 1) {
+        try {
+            auto program = parseSkeleton();
+            std::vector<FunctionDef*> functions;
+            for (ASTNode* decl : program->declarations) {
+                if (decl->type == ASTNodeType::FUNCTION_DEF) {
+                    functions.push_back(static_cast<FunctionDef*>(decl));
+                }
+            }
+            if (functions.size() == bodies.size()) {
+                parseBodies(*program, functions);
+                return program;
+            }
+        } catch (const std::runtime_error&) {
+            // Fall through to the serial parse for the first error in order
+        }
+    }
+    
+    Parser parser(tokens);
+    return parser.parse();
+}
@@ -1,26 +1,27 @@
 #include "parser.h"
+#include <array>
 
-Parser::Parser(const std::vector<Token>& tokens) : tokens(tokens), current(0) {}
+Parser::Parser(TokenSource& source)
+    : tokens(source), arena(nullptr), errors(nullptr), last_error_at(nullptr) {}
 
-Token Parser::currentToken() const {
-    if (current < tokens.size()) {
-        return tokens[current];
-    }
-    return tokens.back();  // Return EOF
+Parser::Parser(const std::vector<Token>& tokens)
+    : owned_source(std::make_unique<VectorTokenSource>(tokens)), tokens(*owned_source),
+      arena(nullptr), errors(nullptr), last_error_at(nullptr) {}
+
+Parser::Parser(const TokenBuffer& tokens)
+    : owned_source(std::make_unique<TokenBufferSource>(tokens)), tokens(*owned_source),
+      arena(nullptr), errors(nullptr), last_error_at(nullptr) {}
+
+const Token& Parser::currentToken() {
+    return tokens.peek(0);
 }
 
-Token Parser::peek(int offset) const {
-    size_t pos = current + offset;
-    if (pos < tokens.size()) {
-        return tokens[pos];
-    }
-    return tokens.back();  // Return EOF
+const Token& Parser::peek(int offset) {
+    return tokens.peek(offset);
 }
 
 void Parser::advance() {
-    if (current < tokens.size() - 1) {
-        current++;
-    }
+    tokens.advance();
 }
 
 bool Parser::match(TokenType type) {
@@ -31,19 +32,9 @@ bool Parser::match(TokenType type) {
     return false;
 }
 
-bool Parser::match(const std::vector<TokenType>& types) {
-    for (TokenType type : types) {
-        if (currentToken().type == type) {
-            advance();
-            return true;
-        }
-    }
-    return false;
-}
-
-void Parser::expect(TokenType type, const std::string& message) {
+void Parser::expect(TokenType type, const char* message) {
     if (currentToken().type != type) {
-        throw ParseError(message + " at line " + std::to_string(currentToken().line));
+        throw ParseError(std::string(message) + " at line " + std::to_string(tokens.line(currentToken())));
     }
     advance();
 }
@@ -52,36 +43,153 @@ std::unique_ptr<Program> Parser::parse() {
     return parseProgram();
 }
 
+std::unique_ptr<Program> Parser::parse(std::vector<std::string>& out) {
+    errors = &out;
+    last_error_at = nullptr;
+    auto program = parseProgram();
+    errors = nullptr;
+    return program;
+}
+
+// Records an error caught while parsing the statement or declaration that
+// began at `start`. Errors reported at the same token as the previous one
+// (typically each enclosing block missing its '}' at end of input) are
+// consequences of it and are dropped.
+void Parser::recordError(const ParseError& error, const char* start) {
+    operators.clear();
+    operands.clear();
+    const char* at = currentToken().lexeme.data();
+    if (at != last_error_at || errors->empty()) {
+        errors->push_back(error.what());
+        last_error_at = at;
+    }
+    // Always move past at least one token
+    if (at == start && !atEnd()) {
+        advance();
+    }
+}
+
+// Panic mode: skips to a point where parsing can resume. Stops after a ';'
+// or a whole '{ ... }' group, before a '}' closing the enclosing block, or
+// before a type keyword that can start the next declaration. At top level
+// a stray '}' is skipped as well.
+void Parser::synchronize(bool top_level) {
+    int depth = 0;
+    while (true) {
+        switch (currentToken().type) {
+            case TokenType::END_OF_FILE:
+                return;
+            case TokenType::LBRACE:
+                depth++;
+                break;
+            case TokenType::RBRACE:
+                if (depth == 0 && !top_level) {
+                    return;
+                }
+                if (depth == 0 || --depth == 0) {
+                    advance();
+                    return;
+                }
+                break;
+            case TokenType::SEMICOLON:
+                if (depth == 0) {
+                    advance();
+                    return;
+                }
+                break;
+            case TokenType::INT:
+            case TokenType::CHAR:
+            case TokenType::VOID:
+            case TokenType::CONST:
+                if (depth == 0) {
+                    return;
+                }
+                break;
+            default:
+                break;
+        }
+        advance();
+    }
+}
+
+// Type spelling such as "int**"; plain types use the static string
+std::string_view Parser::typeName(std::string_view base, int pointer_level) {
+    if (pointer_level == 0) {
+        return base;
+    }
+    std::string spelled(base);
+    spelled.append(pointer_level, '*');
+    return arena->copyString(spelled);
+}
+
+bool Parser::atEnd() {
+    return currentToken().type == TokenType::END_OF_FILE;
+}
+
+void Parser::reuseArena(Arena&& spare) {
+    recycled = std::move(spare);
+    recycled.reset();
+}
+
 std::unique_ptr<Program> Parser::parseProgram() {
     auto program = std::make_unique<Program>();
-    
-    while (currentToken().type != TokenType::END_OF_FILE) {
-        if (currentToken().type == TokenType::CONST) {
-            program->declarations.push_back(parseConstDecl());
-        } else if (currentToken().type == TokenType::INT || 
-                   currentToken().type == TokenType::VOID ||
-                   currentToken().type == TokenType::CHAR) {
-            // Look ahead to distinguish between function and variable
-            // Need to skip potential pointer stars
-            int lookahead = 1;
-            while (peek(lookahead).type == TokenType::MULT) {
-                lookahead++;
+    program->arena = std::move(recycled);
+    arena = &program->arena;
+    
+    try {
+        while (!atEnd()) {
+            const char* start = currentToken().lexeme.data();
+            try {
+                program->declarations.push_back(parseTopLevel());
+            } catch (const ParseError& error) {
+                if (!errors) {
+                    throw;
+                }
+                recordError(error, start);
+                synchronize(true);
             }
-            if (peek(lookahead).type == TokenType::IDENT && peek(lookahead + 1).type == TokenType::LPAREN) {
-                program->declarations.push_back(parseFunctionDef());
-            } else {
-                program->declarations.push_back(parseVarDecl());
-            }
-        } else {
-            throw ParseError("Unexpected token at top level: " + currentToken().lexeme);
         }
+    } catch (...) {
+        // Keep the blocks for reclaimArena
+        recycled = std::move(program->arena);
+        throw;
     }
     
     return program;
 }
 
-std::unique_ptr<FunctionDef> Parser::parseFunctionDef() {
-    std::string return_type;
+ASTNode* Parser::parseDeclaration(Program& program) {
+    arena = &program.arena;
+    return parseTopLevel();
+}
+
+Block* Parser::parseBody(Arena& body_arena) {
+    arena = &body_arena;
+    return parseBlock();
+}
+
+ASTNode* Parser::parseTopLevel() {
+    if (currentToken().type == TokenType::CONST) {
+        return parseConstDecl();
+    } else if (currentToken().type == TokenType::INT || 
+               currentToken().type == TokenType::VOID ||
+               currentToken().type == TokenType::CHAR) {
+        // Look ahead to distinguish between function and variable
+        // Need to skip potential pointer stars
+        int lookahead = 1;
+        while (peek(lookahead).type == TokenType::MULT) {
+            lookahead++;
+        }
+        if (peek(lookahead).type == TokenType::IDENT && peek(lookahead + 1).type == TokenType::LPAREN) {
+            return parseFunctionDef();
+        }
+        return parseVarDecl();
+    }
+    throw ParseError("Unexpected token at top level: " + std::string(currentToken().lexeme));
+}
+
+FunctionDef* Parser::parseFunctionDef() {
+    std::string_view return_type;
     if (match(TokenType::INT)) {
         return_type = "int";
     } else if (match(TokenType::VOID)) {
@@ -93,20 +201,22 @@ std::unique_ptr<FunctionDef> Parser::parseFunctionDef() {
     }
     
     // Handle pointer return types
+    int return_pointer_level = 0;
     while (match(TokenType::MULT)) {
-        return_type += "*";
+        return_pointer_level++;
     }
+    return_type = typeName(return_type, return_pointer_level);
     
-    std::string name = currentToken().lexeme;
+    Symbol name = currentToken().symbol;
     expect(TokenType::IDENT, "Expected function name");
     expect(TokenType::LPAREN, "Expected '('");
     
-    auto func = std::make_unique<FunctionDef>(name, return_type);
+    auto func = make<FunctionDef>(name, return_type);
     
     // Parse parameters
     if (currentToken().type != TokenType::RPAREN) {
         do {
-            std::string param_type;
+            std::string_view param_type;
             if (match(TokenType::INT)) {
                 param_type = "int";
             } else if (match(TokenType::CHAR)) {
@@ -118,14 +228,16 @@ std::unique_ptr<FunctionDef> Parser::parseFunctionDef() {
             }
             
             // Handle pointer parameters
+            int pointer_level = 0;
             while (match(TokenType::MULT)) {
-                param_type += "*";
+                pointer_level++;
             }
+            param_type = typeName(param_type, pointer_level);
             
-            std::string param_name = currentToken().lexeme;
+            Symbol param_name = currentToken().symbol;
             expect(TokenType::IDENT, "Expected parameter name");
             
-            func->params.push_back({param_type, param_name});
+            func->params.push_back(*arena, {param_type, param_name});
         } while (match(TokenType::COMMA));
     }
     
@@ -135,8 +247,8 @@ std::unique_ptr<FunctionDef> Parser::parseFunctionDef() {
     return func;
 }
 
-std::unique_ptr<VarDecl> Parser::parseVarDecl() {
-    std::string var_type;
+VarDecl* Parser::parseVarDecl() {
+    std::string_view var_type;
     if (match(TokenType::INT)) {
         var_type = "int";
     } else if (match(TokenType::CHAR)) {
@@ -148,11 +260,11 @@ std::unique_ptr<VarDecl> Parser::parseVarDecl() {
     // Handle pointer types
     int pointer_level = 0;
     while (match(TokenType::MULT)) {
-        var_type += "*";
         pointer_level++;
     }
+    var_type = typeName(var_type, pointer_level);
     
-    std::string name = currentToken().lexeme;
+    Symbol name = currentToken().symbol;
     expect(TokenType::IDENT, "Expected variable name");
     
     bool is_array = false;
@@ -167,20 +279,20 @@ std::unique_ptr<VarDecl> Parser::parseVarDecl() {
         expect(TokenType::RBRACKET, "Expected ']'");
     }
     
-    std::unique_ptr<Expression> init_value = nullptr;
+    Expression* init_value = nullptr;
     if (match(TokenType::ASSIGN)) {
         init_value = parseExpression();
     }
     
     expect(TokenType::SEMICOLON, "Expected ';'");
     
-    return std::make_unique<VarDecl>(name, var_type, false, is_array, array_size, pointer_level, std::move(init_value));
+    return make<VarDecl>(name, var_type, false, is_array, array_size, pointer_level, init_value);
 }
 
-std::unique_ptr<VarDecl> Parser::parseConstDecl() {
+VarDecl* Parser::parseConstDecl() {
     expect(TokenType::CONST, "Expected 'const'");
     
-    std::string var_type;
+    std::string_view var_type;
     if (match(TokenType::INT)) {
         var_type = "int";
     } else if (match(TokenType::CHAR)) {
@@ -192,11 +304,11 @@ std::unique_ptr<VarDecl> Parser::parseConstDecl() {
     // Handle pointer types
     int pointer_level = 0;
     while (match(TokenType::MULT)) {
-        var_type += "*";
         pointer_level++;
     }
+    var_type = typeName(var_type, pointer_level);
     
-    std::string name = currentToken().lexeme;
+    Symbol name = currentToken().symbol;
     expect(TokenType::IDENT, "Expected constant name");
     
     expect(TokenType::ASSIGN, "Expected '=' for const initialization");
@@ -204,17 +316,26 @@ std::unique_ptr<VarDecl> Parser::parseConstDecl() {
     
     expect(TokenType::SEMICOLON, "Expected ';'");
     
-    return std::make_unique<VarDecl>(name, var_type, true, false, 0, pointer_level, std::move(init_value));
+    return make<VarDecl>(name, var_type, true, false, 0, pointer_level, init_value);
 }
 
-std::unique_ptr<Block> Parser::parseBlock() {
+Block* Parser::parseBlock() {
     expect(TokenType::LBRACE, "Expected '{'");
     
-    auto block = std::make_unique<Block>();
+    auto block = make<Block>();
     
     while (currentToken().type != TokenType::RBRACE && 
            currentToken().type != TokenType::END_OF_FILE) {
-        block->statements.push_back(parseStatement());
+        const char* start = currentToken().lexeme.data();
+        try {
+            block->statements.push_back(*arena, parseStatement());
+        } catch (const ParseError& error) {
+            if (!errors) {
+                throw;
+            }
+            recordError(error, start);
+            synchronize(false);
+        }
     }
     
     expect(TokenType::RBRACE, "Expected '}'");
@@ -222,7 +343,7 @@ std::unique_ptr<Block> Parser::parseBlock() {
     return block;
 }
 
-std::unique_ptr<Statement> Parser::parseStatement() {
+Statement* Parser::parseStatement() {
     if (currentToken().type == TokenType::INT || currentToken().type == TokenType::CHAR) {
         return parseVarDecl();
     } else if (currentToken().type == TokenType::CONST) {
@@ -236,22 +357,22 @@ std::unique_ptr<Statement> Parser::parseStatement() {
     } else if (currentToken().type == TokenType::BREAK) {
         advance();
         expect(TokenType::SEMICOLON, "Expected ';'");
-        return std::make_unique<BreakStmt>();
+        return make<BreakStmt>();
     } else if (currentToken().type == TokenType::CONTINUE) {
         advance();
         expect(TokenType::SEMICOLON, "Expected ';'");
-        return std::make_unique<ContinueStmt>();
+        return make<ContinueStmt>();
     } else if (currentToken().type == TokenType::LBRACE) {
         return parseBlock();
     } else {
         // Expression statement
         auto expr = parseExpression();
         expect(TokenType::SEMICOLON, "Expected ';'");
-        return std::make_unique<ExprStmt>(std::move(expr));
+        return make<ExprStmt>(expr);
     }
 }
 
-std::unique_ptr<IfStmt> Parser::parseIfStmt() {
+IfStmt* Parser::parseIfStmt() {
     expect(TokenType::IF, "Expected 'if'");
     expect(TokenType::LPAREN, "Expected '('");
     
@@ -260,16 +381,16 @@ std::unique_ptr<IfStmt> Parser::parseIfStmt() {
     expect(TokenType::RPAREN, "Expected ')'");
     
     auto then_stmt = parseStatement();
-    std::unique_ptr<Statement> else_stmt = nullptr;
+    Statement* else_stmt = nullptr;
     
     if (match(TokenType::ELSE)) {
         else_stmt = parseStatement();
     }
     
-    return std::make_unique<IfStmt>(std::move(condition), std::move(then_stmt), std::move(else_stmt));
+    return make<IfStmt>(condition, then_stmt, else_stmt);
 }
 
-std::unique_ptr<WhileStmt> Parser::parseWhileStmt() {
+WhileStmt* Parser::parseWhileStmt() {
     expect(TokenType::WHILE, "Expected 'while'");
     expect(TokenType::LPAREN, "Expected '('");
     
@@ -279,207 +400,198 @@ std::unique_ptr<WhileStmt> Parser::parseWhileStmt() {
     
     auto body = parseStatement();
     
-    return std::make_unique<WhileStmt>(std::move(condition), std::move(body));
+    return make<WhileStmt>(condition, body);
 }
 
-std::unique_ptr<ReturnStmt> Parser::parseReturnStmt() {
+ReturnStmt* Parser::parseReturnStmt() {
     expect(TokenType::RETURN, "Expected 'return'");
     
-    std::unique_ptr<Expression> value = nullptr;
+    Expression* value = nullptr;
     if (currentToken().type != TokenType::SEMICOLON) {
         value = parseExpression();
     }
     
     expect(TokenType::SEMICOLON, "Expected ';'");
     
-    return std::make_unique<ReturnStmt>(std::move(value));
+    return make<ReturnStmt>(value);
 }
 
-std::unique_ptr<Expression> Parser::parseExpression() {
-    auto expr = parseLogicalOr();
-    
-    // Handle assignment
-    if (currentToken().type == TokenType::ASSIGN) {
-        advance();
-        auto right = parseExpression();
-        // Convert left to identifier if it is one
-        if (auto* ident = dynamic_cast<IdentExpr*>(expr.get())) {
-            expr = std::make_unique<BinaryExpr>("=", std::move(expr), std::move(right));
-        }
-    }
-    
-    return expr;
-}
+// Binding power of each binary operator token; 0 marks tokens that end an
+// expression. Prefix operators bind tighter than any binary operator.
+struct BinaryBinding {
+    uint8_t power;
+    BinaryOp op;
+};
 
-std::unique_ptr<Expression> Parser::parseLogicalOr() {
-    auto left = parseLogicalAnd();
-    
-    while (match(TokenType::OR)) {
-        left = std::make_unique<BinaryExpr>("||", std::move(left), parseLogicalAnd());
-    }
-    
-    return left;
-}
+static constexpr size_t TOKEN_TYPE_COUNT = static_cast<size_t>(TokenType::UNKNOWN) + 1;
+static constexpr uint8_t ASSIGN_POWER = 1;
+static constexpr uint8_t PREFIX_POWER = 8;
 
-std::unique_ptr<Expression> Parser::parseLogicalAnd() {
-    auto left = parseEquality();
-    
-    while (match(TokenType::AND)) {
-        left = std::make_unique<BinaryExpr>("&&", std::move(left), parseEquality());
-    }
-    
-    return left;
+static constexpr std::array<BinaryBinding, TOKEN_TYPE_COUNT> makeBindingTable() {
+    std::array<BinaryBinding, TOKEN_TYPE_COUNT> table{};
+    auto set = [&table](TokenType type, uint8_t power, BinaryOp op) {
+        table[static_cast<size_t>(type)] = BinaryBinding{power, op};
+    };
+    set(TokenType::ASSIGN, ASSIGN_POWER, BinaryOp::ASSIGN);
+    set(TokenType::OR, 2, BinaryOp::OR);
+    set(TokenType::AND, 3, BinaryOp::AND);
+    set(TokenType::EQ, 4, BinaryOp::EQ);
+    set(TokenType::NE, 4, BinaryOp::NE);
+    set(TokenType::LT, 5, BinaryOp::LT);
+    set(TokenType::LE, 5, BinaryOp::LE);
+    set(TokenType::GT, 5, BinaryOp::GT);
+    set(TokenType::GE, 5, BinaryOp::GE);
+    set(TokenType::PLUS, 6, BinaryOp::ADD);
+    set(TokenType::MINUS, 6, BinaryOp::SUB);
+    set(TokenType::MULT, 7, BinaryOp::MUL);
+    set(TokenType::DIV, 7, BinaryOp::DIV);
+    set(TokenType::MOD, 7, BinaryOp::MOD);
+    return table;
 }
 
-std::unique_ptr<Expression> Parser::parseEquality() {
-    auto left = parseRelational();
-    
-    while (true) {
-        if (match(TokenType::EQ)) {
-            left = std::make_unique<BinaryExpr>("==", std::move(left), parseRelational());
-        } else if (match(TokenType::NE)) {
-            left = std::make_unique<BinaryExpr>("!=", std::move(left), parseRelational());
-        } else {
-            break;
-        }
-    }
-    
-    return left;
-}
+static constexpr std::array<BinaryBinding, TOKEN_TYPE_COUNT> BINARY_BINDINGS = makeBindingTable();
 
-std::unique_ptr<Expression> Parser::parseRelational() {
-    auto left = parseAdditive();
-    
-    while (true) {
-        if (match(TokenType::LT)) {
-            left = std::make_unique<BinaryExpr>("<", std::move(left), parseAdditive());
-        } else if (match(TokenType::LE)) {
-            left = std::make_unique<BinaryExpr>("<=", std::move(left), parseAdditive());
-        } else if (match(TokenType::GT)) {
-            left = std::make_unique<BinaryExpr>(">", std::move(left), parseAdditive());
-        } else if (match(TokenType::GE)) {
-            left = std::make_unique<BinaryExpr>(">=", std::move(left), parseAdditive());
-        } else {
-            break;
-        }
+static bool prefixOperator(TokenType type, UnaryOp& op) {
+    switch (type) {
+        case TokenType::PLUS: op = UnaryOp::PLUS; return true;
+        case TokenType::MINUS: op = UnaryOp::MINUS; return true;
+        case TokenType::NOT: op = UnaryOp::NOT; return true;
+        case TokenType::AMPERSAND: op = UnaryOp::ADDRESS_OF; return true;
+        case TokenType::MULT: op = UnaryOp::DEREFERENCE; return true;
+        case TokenType::INCREMENT: op = UnaryOp::INCREMENT; return true;
+        case TokenType::DECREMENT: op = UnaryOp::DECREMENT; return true;
+        default: return false;
     }
-    
-    return left;
 }
 
-std::unique_ptr<Expression> Parser::parseAdditive() {
-    auto left = parseMultiplicative();
+// Applies the innermost pending operator to the operands on top of the stack
+void Parser::reduce() {
+    PendingOp pending = operators.back();
+    operators.pop_back();
+    Expression* right = operands.back();
+    operands.pop_back();
     
-    while (true) {
-        if (match(TokenType::PLUS)) {
-            left = std::make_unique<BinaryExpr>("+", std::move(left), parseMultiplicative());
-        } else if (match(TokenType::MINUS)) {
-            left = std::make_unique<BinaryExpr>("-", std::move(left), parseMultiplicative());
-        } else {
-            break;
-        }
+    if (pending.kind == PendingOp::PREFIX) {
+        operands.push_back(make<UnaryExpr>(pending.unary, right));
+        return;
     }
     
-    return left;
+    Expression* left = operands.back();
+    if (pending.binary == BinaryOp::ASSIGN && left->type != ASTNodeType::IDENT_EXPR) {
+        return;  // Only identifiers can be assigned; the right side is dropped
+    }
+    operands.back() = make<BinaryExpr>(pending.binary, left, right);
 }
 
-std::unique_ptr<Expression> Parser::parseMultiplicative() {
-    auto left = parseUnary();
+// Precedence climbing over explicit operand/operator stacks. Parentheses,
+// call argument lists and subscripts are pending entries on the operator
+// stack rather than recursive calls, so nesting depth is bounded by memory
+// instead of by the C++ call stack.
+Expression* Parser::parseExpression() {
+    const size_t operator_base = operators.size();
+    const size_t operand_base = operands.size();
     
     while (true) {
-        if (match(TokenType::MULT)) {
-            left = std::make_unique<BinaryExpr>("*", std::move(left), parseUnary());
-        } else if (match(TokenType::DIV)) {
-            left = std::make_unique<BinaryExpr>("/", std::move(left), parseUnary());
-        } else if (match(TokenType::MOD)) {
-            left = std::make_unique<BinaryExpr>("%", std::move(left), parseUnary());
-        } else {
-            break;
+        // Operand position: prefix operators, openers and primaries
+        const Token& token = currentToken();
+        UnaryOp unary;
+        if (prefixOperator(token.type, unary)) {
+            advance();
+            operators.push_back(PendingOp{PendingOp::PREFIX, PREFIX_POWER, BinaryOp::ADD, unary, nullptr, Symbol()});
+            continue;
+        }
+        
+        switch (token.type) {
+            case TokenType::INT_LITERAL: {
+                int value = token.value;
+                advance();
+                operands.push_back(make<IntLiteralExpr>(value));
+                break;
+            }
+            case TokenType::CHAR_LITERAL: {
+                int value = token.value;
+                advance();
+                operands.push_back(make<CharLiteralExpr>(value));
+                break;
+            }
+            case TokenType::STRING_LITERAL: {
+                std::string_view value = arena->copyString(token.string_value);
+                advance();
+                operands.push_back(make<StringLiteralExpr>(value));
+                break;
+            }
+            case TokenType::LPAREN:
+                advance();
+                operators.push_back(PendingOp{PendingOp::GROUP, 0, BinaryOp::ADD, UnaryOp::PLUS, nullptr, Symbol()});
+                continue;
+            case TokenType::IDENT: {
+                Symbol name = token.symbol;
+                advance();
+                if (match(TokenType::LPAREN)) {
+                    auto call = make<CallExpr>(name);
+                    if (!match(TokenType::RPAREN)) {
+                        operators.push_back(PendingOp{PendingOp::CALL, 0, BinaryOp::ADD, UnaryOp::PLUS, call, Symbol()});
+                        continue;
+                    }
+                    operands.push_back(call);
+                } else if (match(TokenType::LBRACKET)) {
+                    operators.push_back(PendingOp{PendingOp::SUBSCRIPT, 0, BinaryOp::ADD, UnaryOp::PLUS, nullptr, name});
+                    continue;
+                } else {
+                    operands.push_back(make<IdentExpr>(name));
+                }
+                break;
+            }
+            default:
+                throw ParseError("Unexpected token in expression: " + std::string(token.lexeme));
         }
-    }
-    
-    return left;
-}
-
-std::unique_ptr<Expression> Parser::parseUnary() {
-    if (match(TokenType::PLUS)) {
-        return std::make_unique<UnaryExpr>("+", parseUnary());
-    } else if (match(TokenType::MINUS)) {
-        return std::make_unique<UnaryExpr>("-", parseUnary());
-    } else if (match(TokenType::NOT)) {
-        return std::make_unique<UnaryExpr>("!", parseUnary());
-    } else if (match(TokenType::AMPERSAND)) {
-        return std::make_unique<UnaryExpr>("&", parseUnary());
-    } else if (match(TokenType::MULT)) {
-        // Dereference operator
-        return std::make_unique<UnaryExpr>("*", parseUnary());
-    } else if (match(TokenType::INCREMENT)) {
-        return std::make_unique<UnaryExpr>("++", parseUnary());
-    } else if (match(TokenType::DECREMENT)) {
-        return std::make_unique<UnaryExpr>("--", parseUnary());
-    }
-    
-    return parsePrimary();
-}
-
-std::unique_ptr<Expression> Parser::parsePrimary() {
-    // Integer literal
-    if (currentToken().type == TokenType::INT_LITERAL) {
-        int value = currentToken().value;
-        advance();
-        return std::make_unique<IntLiteralExpr>(value);
-    }
-    
-    // Character literal
-    if (currentToken().type == TokenType::CHAR_LITERAL) {
-        int value = currentToken().value;
-        advance();
-        return std::make_unique<CharLiteralExpr>(value);
-    }
-    
-    // String literal
-    if (currentToken().type == TokenType::STRING_LITERAL) {
-        std::string value = currentToken().string_value;
-        advance();
-        return std::make_unique<StringLiteralExpr>(value);
-    }
-    
-    // Identifier (variable or function call)
-    if (currentToken().type == TokenType::IDENT) {
-        std::string name = currentToken().lexeme;
-        advance();
         
-        // Function call
-        if (match(TokenType::LPAREN)) {
-            auto call = std::make_unique<CallExpr>(name);
+        // Operator position: binary operators and closers, until the
+        // expression started by this call is complete
+        while (true) {
+            const BinaryBinding& binding = BINARY_BINDINGS[static_cast<size_t>(currentToken().type)];
+            if (binding.power != 0) {
+                // Left-associative, except assignment
+                bool right_assoc = binding.op == BinaryOp::ASSIGN;
+                while (operators.size() > operator_base) {
+                    const PendingOp& top = operators.back();
+                    if (top.power == 0 || top.power < binding.power ||
+                        (right_assoc && top.power == binding.power)) {
+                        break;
+                    }
+                    reduce();
+                }
+                advance();
+                operators.push_back(PendingOp{PendingOp::BINARY, binding.power, binding.op, UnaryOp::PLUS, nullptr, Symbol()});
+                break;
+            }
             
-            if (currentToken().type != TokenType::RPAREN) {
-                do {
-                    call->args.push_back(parseExpression());
-                } while (match(TokenType::COMMA));
+            while (operators.size() > operator_base && operators.back().power != 0) {
+                reduce();
+            }
+            if (operators.size() == operator_base) {
+                Expression* result = operands.back();
+                operands.resize(operand_base);
+                return result;
             }
             
-            expect(TokenType::RPAREN, "Expected ')'");
-            return call;
-        }
-        // Array access
-        else if (match(TokenType::LBRACKET)) {
-            auto index = parseExpression();
-            expect(TokenType::RBRACKET, "Expected ']'");
-            return std::make_unique<ArrayAccess>(name, std::move(index));
-        }
-        // Simple variable
-        else {
-            return std::make_unique<IdentExpr>(name);
+            PendingOp& group = operators.back();
+            Expression* inner = operands.back();
+            if (group.kind == PendingOp::CALL) {
+                group.call->args.push_back(*arena, inner);
+                operands.pop_back();
+                if (match(TokenType::COMMA)) {
+                    break;  // Next argument
+                }
+                expect(TokenType::RPAREN, "Expected ')'");
+                operands.push_back(group.call);
+            } else if (group.kind == PendingOp::SUBSCRIPT) {
+                expect(TokenType::RBRACKET, "Expected ']'");
+                operands.back() = make<ArrayAccess>(group.name, inner);
+            } else {
+                expect(TokenType::RPAREN, "Expected ')'");
+            }
+            operators.pop_back();
         }
     }
-    
-    // Parenthesized expression
-    if (match(TokenType::LPAREN)) {
-        auto expr = parseExpression();
-        expect(TokenType::RPAREN, "Expected ')'");
-        return expr;
-    }
-    
-    throw ParseError("Unexpected token in expression: " + currentToken().lexeme);
 }
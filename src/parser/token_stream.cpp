@@ -0,0 +1,54 @@
+#include "token_stream.h"
+
+VectorTokenSource::VectorTokenSource(const std::vector<Token>& tokens)
+    : tokens(tokens), index(0) {}
+
+Token VectorTokenSource::next() {
+    if (index < tokens.size()) {
+        return tokens[index++];
+    }
+    return tokens.back();  // Return EOF
+}
+
+TokenStream::TokenStream(TokenSource& source)
+    : source(source), ring(INITIAL_LOOKAHEAD), head(0), count(0), at_eof(false) {}
+
+void TokenStream::grow() {
+    std::vector<Token> larger(ring.size() * 2);
+    for (size_t i = 0; i < count; i++) {
+        larger[i] = ring[(head + i) & (ring.size() - 1)];
+    }
+    ring.swap(larger);
+    head = 0;
+}
+
+void TokenStream::fill(size_t needed) {
+    while (count < needed) {
+        if (count == ring.size()) {
+            grow();
+        }
+        size_t slot = (head + count) & (ring.size() - 1);
+        if (at_eof) {
+            // Repeat the END_OF_FILE token instead of pulling past it
+            ring[slot] = ring[(head + count - 1) & (ring.size() - 1)];
+        } else {
+            ring[slot] = source.next();
+            at_eof = ring[slot].type == TokenType::END_OF_FILE;
+        }
+        count++;
+    }
+}
+
+const Token& TokenStream::peek(size_t offset) {
+    fill(offset + 1);
+    return ring[(head + offset) & (ring.size() - 1)];
+}
+
+void TokenStream::advance() {
+    fill(1);
+    if (ring[head].type == TokenType::END_OF_FILE) {
+        return;
+    }
+    head = (head + 1) & (ring.size() - 1);
+    count--;
+}
@@ -0,0 +1,104 @@
+#include "stats.h"
+#include "trace.h"
+#include <ctime>
+#include <iomanip>
+#include <ostream>
+#include <sys/resource.h>
+
+size_t CompileStats::begin(const std::string& name, int depth) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (rows[i].depth == depth && rows[i].name == name) {
+            return i;
+        }
+    }
+    rows.push_back({name, depth, 0, 0.0, 0.0, 0, 0, 0});
+    return rows.size() - 1;
+}
+
+void CompileStats::end(size_t row, double wall_ms, double cpu_ms, size_t items_in, size_t items_out) {
+    long rss = peakRSSKb();
+    std::lock_guard<std::mutex> lock(mutex);
+    Phase& phase = rows[row];
+    phase.runs++;
+    phase.wall_ms += wall_ms;
+    phase.cpu_ms += cpu_ms;
+    phase.items_in += items_in;
+    phase.items_out += items_out;
+    phase.peak_rss_kb = rss;
+}
+
+std::vector<CompileStats::Phase> CompileStats::phases() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rows;
+}
+
+void CompileStats::printTable(std::ostream& os) const {
+    std::vector<Phase> list = phases();
+    std::ios_base::fmtflags flags = os.flags();
+    os << "===--- Compilation time report ---===\n";
+    os << std::left << std::setw(28) << "Phase" << std::right << std::setw(8) << "Runs"
+       << std::setw(12) << "Wall (ms)" << std::setw(12) << "CPU (ms)" << std::setw(12) << "Items in"
+       << std::setw(12) << "Items out" << std::setw(15) << "Peak RSS (KB)" << "\n";
+    os << std::fixed << std::setprecision(3);
+    for (const Phase& phase : list) {
+        std::string indent(static_cast<size_t>(phase.depth) * 2, ' ');
+        os << std::left << std::setw(28) << indent + phase.name << std::right << std::setw(8) << phase.runs
+           << std::setw(12) << phase.wall_ms
+           << std::setw(12) << phase.cpu_ms << std::setw(12) << phase.items_in
+           << std::setw(12) << phase.items_out << std::setw(15) << phase.peak_rss_kb << "\n";
+    }
+    os.flags(flags);
+}
+
+void CompileStats::printJSON(std::ostream& os) const {
+    std::vector<Phase> list = phases();
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3);
+    os << "{\"phases\": [";
+    for (size_t i = 0; i < list.size(); i++) {
+        const Phase& phase = list[i];
+        os << (i ? ",\n  " : "\n  ") << "{\"name\": ";
+        writeJSONString(os, phase.name);
+        os << ", \"depth\": " << phase.depth << ", \"runs\": " << phase.runs
+           << ", \"wall_ms\": " << phase.wall_ms << ", \"cpu_ms\": " << phase.cpu_ms
+           << ", \"items_in\": " << phase.items_in << ", \"items_out\": " << phase.items_out
+           << ", \"peak_rss_kb\": " << phase.peak_rss_kb << "}";
+    }
+    os << "\n], \"peak_rss_kb\": " << peakRSSKb() << "}\n";
+    os.flags(flags);
+}
+
+double CompileStats::threadCPUTimeMs() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<double>(now.tv_sec) * 1e3 + static_cast<double>(now.tv_nsec) / 1e6;
+}
+
+long CompileStats::peakRSSKb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+ScopedPhase::ScopedPhase(CompileStats* stats, const std::string& name, int depth, size_t items_in)
+    : trace(name.c_str()), stats(stats), row(0), items_in(items_in), items_out(0), cpu_start(0.0) {
+    if (stats) {
+        row = stats->begin(name, depth);
+        wall_start = std::chrono::steady_clock::now();
+        cpu_start = CompileStats::threadCPUTimeMs();
+    }
+}
+
+ScopedPhase::~ScopedPhase() {
+    if (trace.active()) {
+        trace.arg("items_in", static_cast<long long>(items_in));
+        trace.arg("items_out", static_cast<long long>(items_out));
+    }
+    if (stats) {
+        double cpu = CompileStats::threadCPUTimeMs() - cpu_start;
+        double wall = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - wall_start).count();
+        stats->end(row, wall, cpu, items_in, items_out);
+    }
+}
@@ -0,0 +1,100 @@
+#include "thread_pool.h"
+#include "trace.h"
+
+// Set on pool threads and while the caller is running a job, so nested
+// parallelFor calls do not wait on workers that are already busy
+static thread_local bool in_pool_task = false;
+
+ThreadPool::ThreadPool(size_t threads) : current(nullptr), stopping(false) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Called with `lock` held; returns with it held
+void ThreadPool::runJob(Job& job, std::unique_lock<std::mutex>& lock) {
+    while (job.next < job.count) {
+        size_t index = job.next++;
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            (*job.task)(index);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        if (error && !job.error) {
+            job.error = error;
+        }
+        if (++job.finished == job.count) {
+            done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    in_pool_task = true;
+    if (Tracer* tracer = Tracer::active()) {
+        tracer->nameThread("worker");
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || (current && current->next < current->count); });
+        if (stopping) {
+            return;
+        }
+        Job& job = *current;
+        job.active++;
+        runJob(job, lock);
+        if (--job.active == 0) {
+            done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    if (workers.empty() || count == 1 || in_pool_task) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    Job job{&task, count, 0, 0, 0, nullptr};
+    std::unique_lock<std::mutex> lock(mutex);
+    // One job at a time; a second caller waits for the pool to drain
+    done.wait(lock, [this] { return current == nullptr; });
+    current = &job;
+    wake.notify_all();
+
+    in_pool_task = true;
+    runJob(job, lock);
+    in_pool_task = false;
+
+    // The job lives on this stack frame, so wait for every worker to let go
+    done.wait(lock, [&job] { return job.finished == job.count && job.active == 0; });
+    current = nullptr;
+    done.notify_all();
+    lock.unlock();
+
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
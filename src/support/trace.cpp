@@ -0,0 +1,108 @@
+#include "trace.h"
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <unistd.h>
+
+std::atomic<Tracer*> Tracer::current{nullptr};
+
+Tracer::Tracer() : start(std::chrono::steady_clock::now()) {}
+
+int Tracer::threadId() {
+    static std::atomic<int> next{1};
+    thread_local int id = next.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+double Tracer::nowUs() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Tracer::record(Event event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(std::move(event));
+}
+
+void Tracer::nameThread(const std::string& name) {
+    int thread = threadId();
+    std::lock_guard<std::mutex> lock(mutex);
+    thread_names.emplace_back(thread, name);
+}
+
+void Tracer::write(std::ostream& os) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ios_base::fmtflags flags = os.flags();
+    long pid = static_cast<long>(getpid());
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    os << "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": " << pid
+       << ", \"tid\": 0, \"args\": {\"name\": \"sysyc\"}}";
+    for (const auto& thread : thread_names) {
+        os << ",\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": " << pid
+           << ", \"tid\": " << thread.first << ", \"args\": {\"name\": ";
+        writeJSONString(os, thread.second);
+        os << "}}";
+    }
+    for (const Event& event : events) {
+        os << ",\n{\"ph\": \"X\", \"name\": ";
+        writeJSONString(os, event.name);
+        os << ", \"pid\": " << pid << ", \"tid\": " << event.thread << ", \"ts\": " << event.start_us
+           << ", \"dur\": " << event.duration_us;
+        if (!event.args.empty()) {
+            os << ", \"args\": {" << event.args << "}";
+        }
+        os << "}";
+    }
+    os << "\n]}\n";
+    os.flags(flags);
+}
+
+TraceScope::TraceScope(const char* name) : tracer(Tracer::active()), start_us(0.0) {
+    if (tracer) {
+        this->name = name;
+        start_us = tracer->nowUs();
+    }
+}
+
+TraceScope::~TraceScope() {
+    end();
+}
+
+void TraceScope::end() {
+    if (tracer) {
+        double end_us = tracer->nowUs();
+        tracer->record({std::move(name), std::move(args), start_us, end_us - start_us, Tracer::threadId()});
+        tracer = nullptr;
+    }
+}
+
+void TraceScope::arg(const char* key, const std::string& value) {
+    if (!tracer) {
+        return;
+    }
+    std::ostringstream member;
+    member << (args.empty() ? "\"" : ", \"") << key << "\": ";
+    writeJSONString(member, value);
+    args += member.str();
+}
+
+void TraceScope::arg(const char* key, long long value) {
+    if (tracer) {
+        args += (args.empty() ? "\"" : ", \"") + std::string(key) + "\": " + std::to_string(value);
+    }
+}
+
+void writeJSONString(std::ostream& os, const std::string& text) {
+    os << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+               << std::dec << std::setfill(' ');
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
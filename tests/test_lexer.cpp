@@ -1,6 +1,11 @@
 #include <iostream>
 #include <cassert>
 #include "lexer.h"
+#include "scan.h"
+#include "parallel_lexer.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 
 void test_keywords() {
     std::string source = "const int void if else while break continue return";
@@ -17,6 +22,11 @@ void test_keywords() {
     assert(tokens[7].type == TokenType::CONTINUE);
     assert(tokens[8].type == TokenType::RETURN);
     
+    static_assert(lookupKeyword("typedef") == TokenType::TYPEDEF, "keyword");
+    static_assert(lookupKeyword("char") == TokenType::CHAR, "keyword");
+    static_assert(lookupKeyword("cont") == TokenType::IDENT, "prefix of keyword");
+    static_assert(lookupKeyword("whilex") == TokenType::IDENT, "keyword prefix");
+    
     std::cout << "test_keywords passed\n";
 }
 
@@ -85,12 +95,183 @@ void test_comments() {
     std::cout << "test_comments passed\n";
 }
 
+void test_string_literals() {
+    std::string source = "\"plain\" \"a\\tb\\n\"";
+    Lexer lexer(source);
+    std::vector<Token> tokens = lexer.tokenize();
+    
+    // Tokens view the source buffer instead of owning copies
+    assert(tokens[0].type == TokenType::STRING_LITERAL);
+    assert(tokens[0].lexeme == "\"plain\"");
+    assert(tokens[0].lexeme.data() == source.data());
+    assert(tokens[0].string_value == "plain");
+    assert(tokens[0].string_value.data() == source.data() + 1);
+    
+    // Escaped literals are decoded into storage owned by the lexer
+    assert(tokens[1].type == TokenType::STRING_LITERAL);
+    assert(tokens[1].lexeme == "\"a\\tb\\n\"");
+    assert(tokens[1].string_value == "a\tb\n");
+    
+    std::cout << "test_string_literals passed\n";
+}
+
+void test_identifier_interning() {
+    std::string source = "count total count _count";
+    Lexer lexer(source);
+    std::vector<Token> tokens = lexer.tokenize();
+    
+    // Equal identifiers share one symbol id; the text is kept by the interner
+    assert(tokens[0].symbol == tokens[2].symbol);
+    assert(tokens[0].symbol != tokens[1].symbol);
+    assert(tokens[0].symbol != tokens[3].symbol);
+    assert(tokens[1].symbol.str() == "total");
+    assert(tokens[1].symbol.str().data() != tokens[1].lexeme.data());
+    assert(Symbol("count") == tokens[0].symbol);
+    assert(Symbol().empty() && Symbol("").empty());
+    
+    std::cout << "test_identifier_interning passed\n";
+}
+
+void test_packed_tokens() {
+    std::string source = "\nint main() {\n    char *s = \"a\\n\";\n  return 'x' + 42;\n}\n";
+    Lexer lexer(source);  // owns the decoded "a\n"
+    std::vector<Token> tokens = lexer.tokenize();
+    TokenBuffer packed = Lexer(source).tokenizePacked();
+    
+    assert(packed.size() == tokens.size());
+    for (size_t i = 0; i < tokens.size(); i++) {
+        Token token = packed.token(i);
+        assert(token.type == tokens[i].type);
+        assert(token.lexeme == tokens[i].lexeme);
+        assert(token.value == tokens[i].value);
+        assert(token.string_value == tokens[i].string_value);
+        assert(token.symbol == tokens[i].symbol);
+        // Positions are derived from the line table, including for EOF
+        assert(token.line == tokens[i].line);
+        assert(token.column == tokens[i].column);
+    }
+    
+    std::string large;
+    for (int i = 0; i < 1000; i++) {
+        large += "int f(int a) { return a * 2 + 1; }\n";
+    }
+    std::vector<Token> large_tokens = Lexer(large).tokenize();
+    TokenBuffer large_packed = Lexer(large).tokenizePacked();
+    assert(large_packed.size() == large_tokens.size());
+    assert(large_packed.memoryUsage() * 2 < large_tokens.size() * sizeof(Token));
+    
+    std::cout << "test_packed_tokens passed\n";
+}
+
+static bool sameTokens(const std::vector<Token>& expected, const std::vector<Token>& actual) {
+    if (expected.size() != actual.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); i++) {
+        const Token& a = expected[i];
+        const Token& b = actual[i];
+        if (a.type != b.type || a.lexeme.data() != b.lexeme.data() || a.lexeme.size() != b.lexeme.size() ||
+            a.line != b.line || a.column != b.column || a.value != b.value ||
+            a.string_value != b.string_value || a.symbol != b.symbol) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_parallel_tokenize() {
+    ThreadPool pool(4);
+    std::vector<std::string> sources;
+    for (const auto& entry : std::filesystem::directory_iterator("examples")) {
+        if (entry.path().extension() == ".sy") {
+            std::ifstream file(entry.path());
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            sources.push_back(buffer.str());
+        }
+    }
+    assert(!sources.empty());
+    
+    // Chunk boundaries inside block comments (with quotes in them), multi-line
+    // strings and character literals
+    std::string tricky;
+    for (int i = 0; i < 50; i++) {
+        tricky += "/* don't \"split\"\n here\n */ int a" + std::to_string(i) + " = 'x';\n";
+        tricky += "char *s = \"line one\n line two \\\" // not a comment\";\n";
+        tricky += "  // it's a comment /* not a block\n";
+        tricky += "/*\n*/\n'\n';\n\n";
+    }
+    sources.push_back(tricky);
+    sources.push_back("\n\n\nint x;\n");
+    
+    for (const std::string& source : sources) {
+        Lexer lexer(source);
+        std::vector<Token> expected = lexer.tokenize();
+        for (size_t chunk : {1, 7, 64, 1000, 1 << 20}) {
+            ParallelLexer parallel(source, pool, chunk);
+            assert(sameTokens(expected, parallel.tokenize()));
+        }
+    }
+    
+    // Lexical errors are reported exactly when the serial Lexer reports them
+    std::string bad = tricky + "char c = 'ab';\n" + tricky;
+    for (size_t chunk : {7, 64}) {
+        bool threw = false;
+        try {
+            ParallelLexer(bad, pool, chunk).tokenize();
+        } catch (const std::runtime_error& e) {
+            threw = std::string(e.what()) == "Expected closing ' in character literal";
+        }
+        assert(threw);
+    }
+    
+    std::cout << "test_parallel_tokenize passed\n";
+}
+
+void test_scan_implementations() {
+    // Runs longer than a vector, split across vector boundaries
+    std::string source = "int " + std::string(70, 'a') + "_9 = 12345;\n";
+    source += std::string(45, ' ') + "\t\r\n\n" + std::string(33, ' ') + "x";
+    source += "// " + std::string(100, '-') + "\n\n";
+    source += "/* " + std::string(40, '*') + "\n" + std::string(50, '\n') + " * / **/ y /**/ z";
+    source += std::string(31, ' ') + "/*" + std::string(31, 'c') + "*/w\n/* unterminated " + std::string(64, '\n');
+    
+    scan::setImpl(scan::Impl::SCALAR);
+    Lexer reference_lexer(source);
+    std::vector<Token> reference = reference_lexer.tokenize();
+    assert(reference.size() == 10);
+    assert(reference[6].lexeme == "y");
+    assert(reference[9].type == TokenType::END_OF_FILE);
+    
+    for (scan::Impl impl : {scan::Impl::SSE2, scan::Impl::AVX2}) {
+        if (!scan::setImpl(impl)) {
+            continue;
+        }
+        Lexer lexer(source);
+        std::vector<Token> tokens = lexer.tokenize();
+        assert(tokens.size() == reference.size());
+        for (size_t i = 0; i < tokens.size(); i++) {
+            assert(tokens[i].type == reference[i].type);
+            assert(tokens[i].lexeme == reference[i].lexeme);
+            assert(tokens[i].line == reference[i].line);
+            assert(tokens[i].column == reference[i].column);
+        }
+    }
+    
+    std::cout << "test_scan_implementations passed\n";
+}
+
 int main() {
     std::cout << "Running Lexer Tests...\n";
     test_keywords();
     test_operators();
     test_identifiers_and_numbers();
     test_comments();
+    test_string_literals();
+    test_identifier_interning();
+    test_packed_tokens();
+    test_parallel_tokenize();
+    test_scan_implementations();
     std::cout << "All lexer tests passed!\n";
     return 0;
 }
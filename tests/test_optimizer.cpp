@@ -1,15 +1,30 @@
 #include <iostream>
+#include <sstream>
 #include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <unistd.h>
+#include "batch_compiler.h"
+#include "codegen.h"
+#include "dominators.h"
 #include "ir.h"
+#include "loops.h"
+#include "ir_cache.h"
+#include "ir_generator.h"
+#include "lexer.h"
 #include "optimizer.h"
+#include "parser.h"
+#include "thread_pool.h"
 
 void test_constant_folding() {
     IRFunction func("test", "int");
     
     // Create IR with constant operands: result = 2 + 3, then use it
-    func.addInstruction(IRInstruction(IROpcode::ADD, "t0", "2", "3"));
-    func.addInstruction(IRInstruction(IROpcode::ADD, "t1", "t0", "1"));
-    func.addInstruction(IRInstruction(IROpcode::RETURN, "t1"));
+    func.addInstruction(IRInstruction(IROpcode::ADD, Operand::temp(0), Operand::imm(2), Operand::imm(3)));
+    func.addInstruction(IRInstruction(IROpcode::ADD, Operand::temp(1), Operand::temp(0), Operand::imm(1)));
+    func.addInstruction(IRInstruction(IROpcode::RETURN, Operand::temp(1)));
     
     Optimizer optimizer;
     IRFunction optimized = optimizer.optimizeFunction(func);
@@ -29,9 +44,9 @@ void test_constant_propagation() {
     IRFunction func("test", "int");
     
     // Create IR: t0 = 5; store t0
-    func.addInstruction(IRInstruction(IROpcode::CONST, "t0", "5"));
-    func.addInstruction(IRInstruction(IROpcode::ADD, "t1", "t0", "10"));
-    func.addInstruction(IRInstruction(IROpcode::STORE, "result", "t1"));
+    func.addInstruction(IRInstruction(IROpcode::CONST, Operand::temp(0), Operand::imm(5)));
+    func.addInstruction(IRInstruction(IROpcode::ADD, Operand::temp(1), Operand::temp(0), Operand::imm(10)));
+    func.addInstruction(IRInstruction(IROpcode::STORE, Operand::var(Symbol("result")), Operand::temp(1)));
     
     Optimizer optimizer;
     IRFunction optimized = optimizer.optimizeFunction(func);
@@ -41,6 +56,12 @@ void test_constant_propagation() {
     size_t optimized_size = optimized.instructions.size();
     
     assert(optimized_size <= original_size);
+    // 5 + 10 is folded into the store
+    bool folded = false;
+    for (const auto& instr : optimized.instructions) {
+        folded |= instr.opcode == IROpcode::STORE && instr.arg1 == Operand::imm(15);
+    }
+    assert(folded);
     std::cout << "test_constant_propagation passed (original: " << original_size 
               << ", optimized: " << optimized_size << ")\n";
 }
@@ -49,9 +70,9 @@ void test_dead_code_elimination() {
     IRFunction func("test", "int");
     
     // Create IR with unused temp variable
-    func.addInstruction(IRInstruction(IROpcode::CONST, "t0", "5"));
-    func.addInstruction(IRInstruction(IROpcode::CONST, "t1", "10"));  // unused
-    func.addInstruction(IRInstruction(IROpcode::RETURN, "t0"));
+    func.addInstruction(IRInstruction(IROpcode::CONST, Operand::temp(0), Operand::imm(5)));
+    func.addInstruction(IRInstruction(IROpcode::CONST, Operand::temp(1), Operand::imm(10)));  // unused
+    func.addInstruction(IRInstruction(IROpcode::RETURN, Operand::temp(0)));
     
     Optimizer optimizer;
     IRFunction optimized = optimizer.optimizeFunction(func);
@@ -59,7 +80,7 @@ void test_dead_code_elimination() {
     // After optimization, t1 should be removed
     bool found_dead = false;
     for (const auto& instr : optimized.instructions) {
-        if (instr.result == "t1") {
+        if (instr.result == Operand::temp(1)) {
             found_dead = true;
         }
     }
@@ -68,11 +89,490 @@ void test_dead_code_elimination() {
     std::cout << "test_dead_code_elimination passed\n";
 }
 
+void test_cfg() {
+    // while (t0) { ... } return; followed by code after the return
+    IRFunction func("loop", "void");
+    Operand header = func.newLabel(), body = func.newLabel(), exit = func.newLabel();
+    Operand cond = func.newTemp();
+    func.addInstruction(IRInstruction(IROpcode::LABEL, header));
+    func.addInstruction(IRInstruction(IROpcode::LOAD, cond, Operand::var(Symbol("n"))));
+    func.addInstruction(IRInstruction(IROpcode::BRANCH, body, cond, exit));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, body));
+    func.addInstruction(IRInstruction(IROpcode::JUMP, header));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, exit));
+    func.addInstruction(IRInstruction(IROpcode::RETURN));
+    func.addInstruction(IRInstruction(IROpcode::JUMP, exit));
+    std::vector<IRInstruction> original = func.instructions;
+
+    func.buildCFG();
+    // entry, header, body, exit, dead jump
+    assert(func.blocks.size() == 5 && func.instructions.empty());
+    assert(func.blocks[0].instructions.empty() && func.blocks[0].preds.empty());
+    assert(func.blocks[0].succs == std::vector<int>({1}));
+    assert(func.blocks[1].label == header && func.blocks[1].succs == std::vector<int>({2, 3}));
+    assert(func.blocks[1].preds == std::vector<int>({0, 2}));
+    assert(func.blocks[3].preds == std::vector<int>({1, 4}) && func.blocks[3].succs.empty());
+    assert(func.blocks[4].terminator()->opcode == IROpcode::JUMP);
+
+    assert(func.removeUnreachableBlocks());
+    assert(!func.removeUnreachableBlocks());
+    assert(func.blocks.size() == 4 && func.blocks[3].preds == std::vector<int>({1}));
+
+    func.linearize();
+    original.pop_back();
+    assert(func.blocks.empty() && func.instructions.size() == original.size());
+    for (size_t i = 0; i < original.size(); i++) {
+        assert(func.instructions[i].toString() == original[i].toString());
+    }
+    std::cout << "test_cfg passed\n";
+}
+
+// Runs straight-line arithmetic and branches; variables and temporaries
+// share one environment
+static int evaluate(const IRFunction& func) {
+    std::unordered_map<Operand, int> values;
+    auto value = [&values](Operand operand) { return operand.isImm() ? operand.value : values[operand]; };
+    auto jump = [&func](Operand label) {
+        for (size_t i = 0; i < func.instructions.size(); i++) {
+            if (func.instructions[i].opcode == IROpcode::LABEL && func.instructions[i].result == label) {
+                return i;
+            }
+        }
+        assert(false);
+        return func.instructions.size();
+    };
+    for (size_t pc = 0; pc < func.instructions.size(); pc++) {
+        const IRInstruction& instr = func.instructions[pc];
+        switch (instr.opcode) {
+            case IROpcode::CONST: case IROpcode::MOVE: case IROpcode::LOAD: case IROpcode::STORE:
+                values[instr.result] = value(instr.arg1);
+                break;
+            case IROpcode::ADD: values[instr.result] = value(instr.arg1) + value(instr.arg2); break;
+            case IROpcode::SUB: values[instr.result] = value(instr.arg1) - value(instr.arg2); break;
+            case IROpcode::JUMP: pc = jump(instr.result); break;
+            case IROpcode::BRANCH: pc = jump(value(instr.arg1) ? instr.result : instr.arg2); break;
+            case IROpcode::RETURN: return value(instr.result);
+            default: break;
+        }
+    }
+    assert(false);
+    return 0;
+}
+
+void test_mem2reg() {
+    // a = 0; b = 1; n = 10; while (n) { t = a; a = b; b = t + b; n = n - 1; } return a;
+    IRFunction func("fib", "int");
+    Operand a = Operand::var(Symbol("a")), b = Operand::var(Symbol("b")), n = Operand::var(Symbol("n"));
+    Operand header = func.newLabel(), body = func.newLabel(), exit = func.newLabel();
+    auto temp = [&func]() { return func.newTemp(); };
+    for (Operand var : {a, b, n}) {
+        func.addInstruction(IRInstruction(IROpcode::ALLOC, var, Operand::imm(4)));
+    }
+    Operand t0 = temp(), t1 = temp(), t2 = temp();
+    func.addInstruction(IRInstruction(IROpcode::CONST, t0, Operand::imm(0)));
+    func.addInstruction(IRInstruction(IROpcode::STORE, a, t0));
+    func.addInstruction(IRInstruction(IROpcode::CONST, t1, Operand::imm(1)));
+    func.addInstruction(IRInstruction(IROpcode::STORE, b, t1));
+    func.addInstruction(IRInstruction(IROpcode::CONST, t2, Operand::imm(10)));
+    func.addInstruction(IRInstruction(IROpcode::STORE, n, t2));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, header));
+    Operand cond = temp();
+    func.addInstruction(IRInstruction(IROpcode::LOAD, cond, n));
+    func.addInstruction(IRInstruction(IROpcode::BRANCH, body, cond, exit));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, body));
+    Operand old_a = temp(), old_b = temp(), sum = temp(), count = temp(), next = temp();
+    func.addInstruction(IRInstruction(IROpcode::LOAD, old_a, a));
+    func.addInstruction(IRInstruction(IROpcode::LOAD, old_b, b));
+    func.addInstruction(IRInstruction(IROpcode::STORE, a, old_b));
+    func.addInstruction(IRInstruction(IROpcode::ADD, sum, old_a, old_b));
+    func.addInstruction(IRInstruction(IROpcode::STORE, b, sum));
+    func.addInstruction(IRInstruction(IROpcode::LOAD, count, n));
+    func.addInstruction(IRInstruction(IROpcode::SUB, next, count, Operand::imm(1)));
+    func.addInstruction(IRInstruction(IROpcode::STORE, n, next));
+    func.addInstruction(IRInstruction(IROpcode::JUMP, header));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, exit));
+    Operand result = temp();
+    func.addInstruction(IRInstruction(IROpcode::LOAD, result, a));
+    func.addInstruction(IRInstruction(IROpcode::RETURN, result));
+    assert(evaluate(func) == 55);
+    
+    // The loop body's frontier is the header, where all three get phis
+    IRFunction cfg = func;
+    cfg.buildCFG();
+    DominatorTree dominators(cfg);
+    assert(dominators.idom(1) == 0 && dominators.idom(2) == 1 && dominators.idom(3) == 1);
+    assert(dominators.frontier(2) == std::vector<int>({1}) && dominators.dominates(1, 3));
+    
+    IRFunction optimized = Optimizer().optimizeFunction(func);
+    for (const auto& instr : optimized.instructions) {
+        assert(instr.opcode != IROpcode::ALLOC && instr.opcode != IROpcode::LOAD &&
+               instr.opcode != IROpcode::STORE);
+    }
+    assert(evaluate(optimized) == 55);
+    std::cout << "test_mem2reg passed\n";
+}
+
+static IRFunction compileMain(const std::string& source, bool optimize) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto program = parser.parse();
+    IRModule module = IRGenerator().generate(program.get());
+    return optimize ? Optimizer().optimizeFunction(module.functions[0]) : module.functions[0];
+}
+
+void test_mem2reg_keeps_memory() {
+    // The inner x is a second ALLOC of the same name, not a new value of
+    // the outer one
+    std::string shadowed = "int main() {\n    int x = 5;\n    {\n        int x;\n    }\n    return x;\n}\n";
+    assert(evaluate(compileMain(shadowed, false)) == 5);
+    assert(evaluate(compileMain(shadowed, true)) == 5);
+    
+    // Arrays stay allocated, whatever their size
+    for (const char* source : {"int main() { int a[10]; int x; x = a[2]; return x; }",
+                               "int main() { int a[4]; return a[1]; }"}) {
+        IRFunction optimized = compileMain(source, true);
+        const IRInstruction& alloc = optimized.instructions[0];
+        assert(alloc.opcode == IROpcode::ALLOC && alloc.result == Operand::var(Symbol("a")));
+    }
+    std::cout << "test_mem2reg_keeps_memory passed\n";
+}
+
+void test_loops() {
+    // while (n) { while (m) { } }: blocks are entry, outer header, outer
+    // body, inner header, inner body, outer latch, exit
+    IRFunction func("nested", "void");
+    Operand outer = func.newLabel(), outer_body = func.newLabel(), inner = func.newLabel();
+    Operand inner_body = func.newLabel(), latch = func.newLabel(), exit = func.newLabel();
+    Operand n = func.newTemp(), m = func.newTemp();
+    func.addInstruction(IRInstruction(IROpcode::LABEL, outer));
+    func.addInstruction(IRInstruction(IROpcode::LOAD, n, Operand::var(Symbol("n"))));
+    func.addInstruction(IRInstruction(IROpcode::BRANCH, outer_body, n, exit));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, outer_body));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, inner));
+    func.addInstruction(IRInstruction(IROpcode::LOAD, m, Operand::var(Symbol("m"))));
+    func.addInstruction(IRInstruction(IROpcode::BRANCH, inner_body, m, latch));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, inner_body));
+    func.addInstruction(IRInstruction(IROpcode::JUMP, inner));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, latch));
+    func.addInstruction(IRInstruction(IROpcode::JUMP, outer));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, exit));
+    func.addInstruction(IRInstruction(IROpcode::RETURN));
+    func.buildCFG();
+    
+    const LoopInfo& loops = func.loopInfo();
+    assert(loops.loops().size() == 2);
+    const Loop& outer_loop = loops.loop(0);
+    const Loop& inner_loop = loops.loop(1);
+    assert(outer_loop.header == 1 && outer_loop.parent == -1 && outer_loop.depth == 1);
+    assert(outer_loop.blocks == std::vector<int>({1, 2, 3, 4, 5}));
+    assert(outer_loop.latches == std::vector<int>({5}));
+    assert(inner_loop.header == 3 && inner_loop.parent == 0 && inner_loop.depth == 2);
+    assert(inner_loop.blocks == std::vector<int>({3, 4}) && outer_loop.children == std::vector<int>({1}));
+    assert(loops.depth(0) == 0 && loops.depth(2) == 1 && loops.depth(4) == 2 && loops.depth(6) == 0);
+    assert(loops.loopFor(5) == 0 && loops.contains(0, 4) && !loops.contains(1, 5));
+    
+    // Cached until the CFG changes
+    assert(&func.loopInfo() == &loops && &func.dominatorTree() == &func.dominatorTree());
+    assert(func.dominatorTree().idom(3) == 2 && func.dominatorTree().idom(6) == 1);
+    func.removeEdge(4, 3);
+    const LoopInfo& outer_only = func.loopInfo();
+    assert(outer_only.loops().size() == 1 && outer_only.depth(3) == 1 && outer_only.depth(4) == 0);
+    std::cout << "test_loops passed\n";
+}
+
+void test_def_use() {
+    // if (c) t1 = 4 else t2 = t0 + 1; t3 = phi(t1, t2); return t3 * t3
+    IRFunction func("diamond", "int");
+    Operand then_label = func.newLabel(), else_label = func.newLabel(), join = func.newLabel();
+    Operand t0 = func.newTemp(), t1 = func.newTemp(), t2 = func.newTemp();
+    Operand t3 = func.newTemp(), t4 = func.newTemp();
+    func.addInstruction(IRInstruction(IROpcode::LOAD, t0, Operand::var(Symbol("c"))));
+    func.addInstruction(IRInstruction(IROpcode::BRANCH, then_label, t0, else_label));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, then_label));
+    func.addInstruction(IRInstruction(IROpcode::CONST, t1, Operand::imm(4)));
+    func.addInstruction(IRInstruction(IROpcode::JUMP, join));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, else_label));
+    func.addInstruction(IRInstruction(IROpcode::ADD, t2, t0, Operand::imm(1)));
+    func.addInstruction(IRInstruction(IROpcode::JUMP, join));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, join));
+    func.addInstruction(IRInstruction(IROpcode::MUL, t4, t3, t3));
+    func.addInstruction(IRInstruction(IROpcode::RETURN, t4));
+    func.buildCFG();
+    func.blocks[3].phis.push_back({t3, {t1, t2}});
+    func.buildDefUse();
+    
+    DefSite phi_def = func.def(t3);
+    assert(phi_def.unique() && phi_def.phi && phi_def.block == 3 && phi_def.index == 0);
+    assert(func.def(t2).block == 2 && func.def(t2).index == 1 && !func.def(t2).phi);
+    assert(func.uses(t0).size() == 2 && func.uses(t3).size() == 2 && func.uses(t4).size() == 1);
+    const UseSite& ret = func.uses(t4)[0];
+    assert(ret.block == 3 && ret.slot == 0 && !ret.phi);
+    assert(&func.operandAt(ret) == &func.blocks[3].instructions[2].result);
+    
+    func.replaceAllUsesWith(t1, Operand::imm(4));
+    assert(func.uses(t1).empty() && func.blocks[3].phis[0].incoming[0] == Operand::imm(4));
+    func.eraseInstruction(1, 1);
+    assert(func.blocks[1].instructions[1].opcode == IROpcode::NOP && !func.def(t1).unique());
+    
+    // The phi's uses move to t2, and go away with the phi
+    func.replaceAllUsesWith(t3, t2);
+    assert(func.uses(t3).empty() && func.uses(t2).size() == 3);
+    assert(func.blocks[3].instructions[1].arg1 == t2 && func.blocks[3].instructions[1].arg2 == t2);
+    func.erasePhi(3, 0);
+    assert(func.uses(t2).size() == 2 && func.def(t3).block == DefSite::NONE);
+    
+    func.compact();
+    assert(!func.hasDefUse() && func.blocks[1].instructions.size() == 2 && func.blocks[3].phis.empty());
+    func.buildDefUse();
+    assert(func.uses(t2).size() == 2 && func.def(t4).index == 1);
+    func.removeEdge(0, 2);
+    assert(!func.hasDefUse());
+    std::cout << "test_def_use passed\n";
+}
+
+void test_pass_manager() {
+    // t0 = 1; t1 = t0 + 1; ...; t200 = t199 + 1; return t200 folds down one
+    // link per visit, well past any fixed number of rescans
+    IRFunction func("chain", "int");
+    Operand value = func.newTemp();
+    func.addInstruction(IRInstruction(IROpcode::CONST, value, Operand::imm(1)));
+    for (int i = 0; i < 200; i++) {
+        Operand next = func.newTemp();
+        func.addInstruction(IRInstruction(IROpcode::ADD, next, value, Operand::imm(1)));
+        value = next;
+    }
+    func.addInstruction(IRInstruction(IROpcode::RETURN, value));
+    
+    Optimizer optimizer;
+    IRFunction optimized = optimizer.optimizeFunction(func);
+    assert(optimized.instructions.size() == 1);
+    assert(optimized.instructions[0].opcode == IROpcode::RETURN);
+    assert(optimized.instructions[0].result == Operand::imm(201));
+    // Each instruction is queued again at most once, when its operand
+    // becomes a constant
+    assert(optimizer.passManager().visitCount() <= 2 * (func.instructions.size() + 1));
+    
+    // Statistics: a row per pass and per sparse phase, nested under the
+    // caller's depth
+    CompileStats stats;
+    optimizer.setStats(&stats);
+    optimizer.optimizeFunction(func);
+    optimizer.optimizeFunction(func);
+    std::vector<CompileStats::Phase> rows = stats.phases();
+    assert(rows.size() == 8 && rows[0].name == "cfg" && rows[0].depth == 1);
+    assert(rows[3].name == "constfold+constprop+dce" && rows[4].name == "constfold" && rows[4].depth == 2);
+    assert(rows[3].runs == 2 && rows[3].items_in == 2 * func.instructions.size() && rows[3].items_out == 2);
+    assert(rows[7].name == "out-of-ssa" && rows[7].peak_rss_kb > 0);
+    
+    // Trace spans: one per optimized function, with the passes inside it
+    Tracer tracer;
+    Tracer::install(&tracer);
+    Optimizer().optimizeFunction(func);
+    Tracer::install(nullptr);
+    std::ostringstream trace;
+    tracer.write(trace);
+    std::string json = trace.str();
+    assert(json.find("\"name\": \"optimizeFunction\"") != std::string::npos);
+    assert(json.find("\"function\": \"chain\", \"instructions\": 202") != std::string::npos);
+    assert(json.find("\"name\": \"mem2reg\"") != std::string::npos);
+    
+    // Analyses a pass declares are built before it runs and the ones it
+    // does not preserve are dropped after it changes something
+    PassManager passes;
+    bool saw_def_use = false;
+    passes.addPass("check", ANALYSIS_DEF_USE, ANALYSIS_ALL, [&](IRFunction& f) {
+        saw_def_use = f.hasDefUse();
+        return true;
+    });
+    passes.addPass("clobber", ANALYSIS_NONE, ANALYSIS_DOMINATORS | ANALYSIS_LOOPS, [](IRFunction&) {
+        return true;
+    });
+    IRFunction target = func;
+    target.buildCFG();
+    passes.run(target);
+    assert(saw_def_use && !target.hasDefUse());
+    std::cout << "test_pass_manager passed\n";
+}
+
+void test_parallel_backend() {
+    // Functions of different sizes, so the pool does not take them in order
+    IRModule module;
+    for (int f = 0; f < 12; f++) {
+        IRFunction func("f" + std::to_string(f), "int");
+        func.params = {Symbol("a")};
+        Operand value = Operand::var(Symbol("a"));
+        Operand folded = func.newTemp();
+        func.addInstruction(IRInstruction(IROpcode::CONST, folded, Operand::imm(f)));
+        for (int i = 0; i < (f * 7) % 12 * 10 + 1; i++) {
+            Operand next = func.newTemp();
+            func.addInstruction(IRInstruction(IROpcode::ADD, next, value, folded));
+            value = next;
+        }
+        func.addInstruction(IRInstruction(IROpcode::RETURN, value));
+        module.addFunction(func);
+    }
+    std::vector<size_t> order = module.largestFirst();
+    assert(order.size() == 12 && order[0] == 5 && order[11] == 0);
+    
+    IRModule expected = Optimizer().optimize(module);
+    std::string expected_asm = CodeGenerator().generate(expected);
+    ThreadPool pool(4);
+    IRModule optimized = Optimizer().optimize(module, pool);
+    assert(optimized.toString() == expected.toString());
+    assert(CodeGenerator().generate(optimized, pool) == expected_asm);
+    std::cout << "test_parallel_backend passed\n";
+}
+
+void test_ir_cache() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() /
+                                ("sysyc_ir_cache_test_" + std::to_string(getpid()));
+    std::filesystem::remove_all(dir);
+    
+    IRModule module;
+    IRFunction func("add", "int*");
+    func.params = {Symbol("a"), Symbol("b")};
+    func.addInstruction(IRInstruction(IROpcode::ADD, func.newTemp(), Operand::var(Symbol("a")),
+                                      Operand::var(Symbol("b"))));
+    func.addInstruction(IRInstruction(IROpcode::CONST, func.newTemp(), Operand::var(Symbol("\"hi\\n\""))));
+    func.addInstruction(IRInstruction(IROpcode::SUB, func.newTemp(), Operand::imm(-7), Operand::temp(0)));
+    func.addInstruction(IRInstruction(IROpcode::LABEL, func.newLabel()));
+    func.addInstruction(IRInstruction(IROpcode::RETURN));
+    module.addFunction(func);
+    module.addFunction(IRFunction("empty", "void"));
+    module.global_vars["counter"] = 0;
+    std::string source = "int counter; int* add(int a, int b) { ... }";
+    
+    IRCache cache(dir.string());
+    IRModule loaded;
+    assert(!cache.load(source, "-O1", loaded));
+    assert(cache.store(source, "-O1", module));
+    assert(cache.load(source, "-O1", loaded));
+    assert(loaded.toString() == module.toString());
+    assert(loaded.functions[0].return_type == "int*");
+    assert(loaded.functions[0].temp_counter == 3 && loaded.functions[0].label_counter == 1);
+    assert(loaded.functions[0].instructions[2].arg1 == Operand::imm(-7));
+    
+    // Different flags or source are different entries
+    assert(!cache.load(source, "-O0", loaded));
+    assert(!cache.load(source + " ", "-O1", loaded));
+    
+    // An entry found under another source's key (a hash collision) is a
+    // miss, even for a source of the same length
+    std::string other = source;
+    other[0] = 'I';
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ir", static_cast<unsigned long long>(IRCache::hash(other, "-O1")));
+    std::filesystem::copy_file(std::filesystem::directory_iterator(dir)->path(), dir / name);
+    assert(!cache.load(other, "-O1", loaded));
+    std::filesystem::remove(dir / name);
+    
+    // A truncated entry is a miss, not an error
+    std::filesystem::path entry = std::filesystem::directory_iterator(dir)->path();
+    std::filesystem::resize_file(entry, std::filesystem::file_size(entry) - 3);
+    assert(!cache.load(source, "-O1", loaded));
+    
+    assert(cache.hitCount() == 1 && cache.missCount() == 5);
+    
+    // Threads sharing the cache may store the same source at once; each
+    // writes its own temporary file
+    ThreadPool pool(4);
+    pool.parallelFor(16, [&](size_t) { assert(cache.store(source, "-O2", module)); });
+    assert(cache.load(source, "-O2", loaded) && loaded.toString() == module.toString());
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        assert(entry.path().extension() == ".ir");
+    }
+    std::filesystem::remove_all(dir);
+    std::cout << "test_ir_cache passed\n";
+}
+
+void test_batch_compiler() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() /
+                                ("sysyc_batch_test_" + std::to_string(getpid()));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "out");
+    std::vector<std::string> sources;
+    for (int i = 0; i < 6; i++) {
+        std::string source = "int main() {\n    int x = " + std::to_string(i) + ";\n";
+        for (int j = 0; j < i * 10; j++) {
+            source += "    x = x * 3 + " + std::to_string(j) + ";\n";
+        }
+        sources.push_back(source + "    return x;\n}\n");
+    }
+    sources.push_back("int main( {\n");
+    std::vector<BatchCompiler::Unit> units(sources.size());
+    std::ofstream list(dir / "files.txt");
+    list << "# inputs\n\n";
+    for (size_t i = 0; i < sources.size(); i++) {
+        units[i].input = (dir / ("unit" + std::to_string(i) + ".sy")).string();
+        units[i].output = BatchCompiler::outputPath(units[i].input, (dir / "out").string());
+        std::ofstream(units[i].input) << sources[i];
+        list << "  " << units[i].input << "\n";
+    }
+    list.close();
+    assert(BatchCompiler::readFileList((dir / "files.txt").string()).size() == units.size());
+    assert(units[0].output == (dir / "out" / "unit0.s").string());
+    
+    ThreadPool pool(3);
+    BatchCompiler compiler(pool, true);
+    assert(compiler.compile(units) == 1);
+    // Each unit's output is what compiling it alone gives
+    ThreadPool inline_pool(1);
+    BatchCompiler single(inline_pool, true);
+    for (size_t i = 0; i + 1 < units.size(); i++) {
+        std::string expected;
+        std::vector<std::string> errors;
+        assert(single.compileSource(sources[i], expected, errors));
+        std::ifstream file(units[i].output);
+        std::stringstream written;
+        written << file.rdbuf();
+        assert(units[i].ok && units[i].errors.empty() && written.str() == expected);
+    }
+    assert(!units.back().ok && units.back().errors.size() == 1);
+    assert(!std::filesystem::exists(units.back().output));
+    
+    // A unit that throws part way through parsing still hands its arena back
+    size_t spare = single.spareArenaCount();
+    std::string assembly;
+    std::vector<std::string> errors;
+    bool thrown = false;
+    try {
+        single.compileSource("int main() { return \"open; }", assembly, errors);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown && spare > 0 && single.spareArenaCount() == spare);
+    
+    // Same-named inputs from different directories would share an output
+    std::vector<BatchCompiler::Unit> clashing(2);
+    for (const char* sub : {"a", "b"}) {
+        std::filesystem::create_directories(dir / sub);
+        BatchCompiler::Unit& unit = clashing[sub[0] - 'a'];
+        unit.input = (dir / sub / "same.sy").string();
+        unit.output = BatchCompiler::outputPath(unit.input, (dir / "clash").string());
+        std::ofstream(unit.input) << sources[0];
+    }
+    assert(compiler.compile(clashing) == 2);
+    assert(clashing[0].errors.size() == 1 && clashing[0].errors[0].find(clashing[1].input) != std::string::npos);
+    assert(clashing[1].errors.size() == 1 && clashing[1].errors[0].find(clashing[0].input) != std::string::npos);
+    assert(!std::filesystem::exists(clashing[0].output));
+    std::filesystem::remove_all(dir);
+    std::cout << "test_batch_compiler passed\n";
+}
+
 int main() {
     std::cout << "Running Optimizer Tests...\n";
     test_constant_folding();
     test_constant_propagation();
     test_dead_code_elimination();
+    test_cfg();
+    test_mem2reg();
+    test_mem2reg_keeps_memory();
+    test_loops();
+    test_def_use();
+    test_pass_manager();
+    test_parallel_backend();
+    test_ir_cache();
+    test_batch_compiler();
     std::cout << "All optimizer tests passed!\n";
     return 0;
 }
@@ -1,7 +1,14 @@
 #include <iostream>
 #include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 #include "lexer.h"
 #include "parser.h"
+#include "incremental_parser.h"
+#include "flat_ast.h"
+#include "parallel_parser.h"
+#include "ir_generator.h"
 
 void test_simple_function() {
     std::string source = "int main() { return 0; }";
@@ -29,7 +36,7 @@ void test_function_with_params() {
     assert(program != nullptr);
     assert(program->declarations.size() == 1);
     
-    FunctionDef* func = dynamic_cast<FunctionDef*>(program->declarations[0].get());
+    FunctionDef* func = dynamic_cast<FunctionDef*>(program->declarations[0]);
     assert(func != nullptr);
     assert(func->name == "add");
     assert(func->params.size() == 2);
@@ -73,9 +80,380 @@ void test_expressions() {
     
     assert(program != nullptr);
     
+    // x = 1 + 2 * 3 parses as ASSIGN(x, ADD(1, MUL(2, 3)))
+    FunctionDef* func = dynamic_cast<FunctionDef*>(program->declarations[0]);
+    ExprStmt* stmt = dynamic_cast<ExprStmt*>(func->body->statements[1]);
+    BinaryExpr* assign = dynamic_cast<BinaryExpr*>(stmt->expr);
+    assert(assign->op == BinaryOp::ASSIGN);
+    BinaryExpr* sum = dynamic_cast<BinaryExpr*>(assign->right);
+    assert(sum->op == BinaryOp::ADD);
+    assert(dynamic_cast<BinaryExpr*>(sum->right)->op == BinaryOp::MUL);
+    
     std::cout << "test_expressions passed\n";
 }
 
+void test_streaming_from_lexer() {
+    // More pointer stars than the initial lookahead window holds
+    std::string stars(TokenStream::INITIAL_LOOKAHEAD * 3, '*');
+    std::string source = "int " + stars + "table; int *lookup(int *key) { return key; } int main() { return 0; }";
+    Lexer lexer(source);
+    
+    Parser parser(lexer);
+    auto program = parser.parse();
+    
+    assert(program != nullptr);
+    assert(program->declarations.size() == 3);
+    assert(program->declarations[0]->type == ASTNodeType::VAR_DECL);
+    assert(program->declarations[1]->type == ASTNodeType::FUNCTION_DEF);
+    assert(program->declarations[2]->type == ASTNodeType::FUNCTION_DEF);
+    
+    VarDecl* table = dynamic_cast<VarDecl*>(program->declarations[0]);
+    assert(table->pointer_level == static_cast<int>(stars.size()));
+    assert(lexer.tokenCount() == Lexer(source).tokenize().size());
+    
+    std::cout << "test_streaming_from_lexer passed\n";
+}
+
+void test_packed_tokens_and_error_line() {
+    std::string source = "int add(int a, int b) {\n    return a + b;\n}\n";
+    TokenBuffer tokens = Lexer(source).tokenizePacked();
+    
+    Parser parser(tokens);
+    auto program = parser.parse();
+    assert(program->declarations.size() == 1);
+    
+    // Line numbers are only computed when the error is reported
+    std::string bad = "int main() {\n    int x = 1\n    return x;\n}\n";
+    TokenBuffer bad_tokens = Lexer(bad).tokenizePacked();
+    Parser bad_parser(bad_tokens);
+    bool threw = false;
+    try {
+        bad_parser.parse();
+    } catch (const ParseError& e) {
+        threw = std::string(e.what()) == "Expected ';' at line 3";
+    }
+    assert(threw);
+    
+    std::cout << "test_packed_tokens_and_error_line passed\n";
+}
+
+static std::string irOf(Program* program) {
+    IRGenerator generator;
+    return generator.generate(program).toString();
+}
+
+static std::string irOf(const std::string& source) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    return irOf(parser.parse().get());
+}
+
+void test_incremental_reparse() {
+    std::string source = "int total;\n";
+    for (int i = 0; i < 40; i++) {
+        std::string n = std::to_string(i);
+        source += "// helper " + n + "\nint f" + n + "(int x) {\n    return x * " + n + ";\n}\n\n";
+    }
+    IncrementalParser incremental(source);
+    Program* program = incremental.getProgram();
+    assert(program->declarations.size() == 41);
+    std::vector<ASTNode*> before;
+    for (auto& decl : program->declarations) {
+        before.push_back(decl);
+    }
+    
+    // Editing one body re-parses just that function and keeps the others
+    size_t at = source.find("x * 20;");
+    incremental.applyEdit(TextEdit{at + 4, 2, "(x + 1) - 7"});
+    source.replace(at + 4, 2, "(x + 1) - 7");
+    assert(incremental.text() == source);
+    assert(incremental.lastReparsedBytes() < 100);
+    for (size_t i = 0; i < before.size(); i++) {
+        assert((program->declarations[i] == before[i]) == (i != 21));
+    }
+    assert(irOf(program) == irOf(source));
+    
+    // A new declaration typed between two functions
+    at = source.find("int f5(");
+    incremental.applyEdit(TextEdit{at, 0, "int g(int y) { return f4(y); }\n"});
+    source.insert(at, "int g(int y) { return f4(y); }\n");
+    assert(program->declarations.size() == 42);
+    assert(irOf(program) == irOf(source));
+    
+    // Opening a comment swallows the rest of the file; the error matches a
+    // full parse, and closing it again recovers
+    at = source.find("return x * 30;");
+    bool threw = false;
+    try {
+        incremental.applyEdit(TextEdit{at, 0, "/* "});
+    } catch (const ParseError&) {
+        threw = true;
+    }
+    assert(threw);
+    incremental.applyEdit(TextEdit{at, 3, ""});
+    assert(incremental.text() == source);
+    program = incremental.getProgram();
+    assert(irOf(program) == irOf(source));
+    
+    // Deleting a closing brace and putting it back
+    at = source.find("}", source.find("int f12("));
+    threw = false;
+    try {
+        incremental.applyEdit(TextEdit{at, 1, ""});
+    } catch (const ParseError&) {
+        threw = true;
+    }
+    assert(threw);
+    incremental.applyEdit(TextEdit{at, 0, "}"});
+    assert(incremental.text() == source);
+    assert(irOf(incremental.getProgram()) == irOf(source));
+    
+    std::cout << "test_incremental_reparse passed\n";
+}
+
+static Expression* returnedExpression(Program* program) {
+    auto* func = static_cast<FunctionDef*>(program->declarations.back());
+    return static_cast<ReturnStmt*>(func->body->statements[0])->value;
+}
+
+void test_precedence_and_nesting() {
+    // Left-associative subtraction, prefix binding tighter than '*',
+    // right-associative assignment
+    std::string source = "int main() { return -a * b - c - d; }";
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto program = parser.parse();
+    auto* outer = static_cast<BinaryExpr*>(returnedExpression(program.get()));
+    assert(outer->op == BinaryOp::SUB && outer->right->type == ASTNodeType::IDENT_EXPR);
+    auto* inner = static_cast<BinaryExpr*>(outer->left);
+    assert(inner->op == BinaryOp::SUB);
+    auto* product = static_cast<BinaryExpr*>(inner->left);
+    assert(product->op == BinaryOp::MUL && product->left->type == ASTNodeType::UNARY_EXPR);
+    
+    std::string chain = "int main() { return a = b = c || d && e; }";
+    Lexer chain_lexer(chain);
+    Parser chain_parser(chain_lexer);
+    auto chained = chain_parser.parse();
+    auto* assign = static_cast<BinaryExpr*>(returnedExpression(chained.get()));
+    assert(assign->op == BinaryOp::ASSIGN);
+    auto* inner_assign = static_cast<BinaryExpr*>(assign->right);
+    assert(inner_assign->op == BinaryOp::ASSIGN);
+    assert(static_cast<BinaryExpr*>(inner_assign->right)->op == BinaryOp::OR);
+    
+    // Nesting far deeper than the call stack could take recursively
+    const int depth = 200000;
+    std::string deep = "int main() { return ";
+    for (int i = 0; i < depth; i++) {
+        deep += i % 4 == 0 ? "(" : i % 4 == 1 ? "-" : i % 4 == 2 ? "f(1, " : "t[";
+    }
+    deep += "x";
+    for (int i = depth - 1; i >= 0; i--) {
+        deep += i % 4 == 0 ? ")" : i % 4 == 1 ? "" : i % 4 == 2 ? ")" : "]";
+    }
+    deep += "; }";
+    Lexer deep_lexer(deep);
+    Parser deep_parser(deep_lexer);
+    auto nested = deep_parser.parse();
+    Expression* expr = returnedExpression(nested.get());
+    int levels = 0;
+    while (expr->type != ASTNodeType::IDENT_EXPR) {
+        if (expr->type == ASTNodeType::UNARY_EXPR) {
+            expr = static_cast<UnaryExpr*>(expr)->operand;
+        } else if (expr->type == ASTNodeType::CALL_EXPR) {
+            expr = static_cast<CallExpr*>(expr)->args[1];
+        } else {
+            expr = static_cast<ArrayAccess*>(expr)->index;
+        }
+        levels++;
+    }
+    assert(levels == depth / 4 * 3);
+    
+    std::cout << "test_precedence_and_nesting passed\n";
+}
+
+void test_flat_ast() {
+    std::string source = "int g;\n"
+                         "int f(int a, char* s) { int t[4]; t[0] = -a; if (!a) return +a; else { while (a) { a = a - 1; if (a == 2) break; continue; } } return f(a, \"x\\n\"); }\n"
+                         "void h() { return; }\n";
+    std::vector<std::string> sources{source};
+    for (const auto& entry : std::filesystem::directory_iterator("examples")) {
+        if (entry.path().extension() == ".sy") {
+            std::ifstream file(entry.path());
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            sources.push_back(buffer.str());
+        }
+    }
+    
+    for (const std::string& text : sources) {
+        Lexer lexer(text);
+        Parser parser(lexer);
+        auto program = parser.parse();
+        FlatAST flat = FlatAST::build(*program);
+        assert(flat.declarations.size() == program->declarations.size());
+        for (size_t i = 0; i < flat.declarations.size(); i++) {
+            assert(flat[flat.declarations[i]].kind == program->declarations[i]->type);
+        }
+        // Pre-order: every child comes after its parent
+        for (uint32_t i = 1; i < flat.nodes.size(); i++) {
+            const FlatNode& node = flat[i];
+            if (node.kind == ASTNodeType::BLOCK || node.kind == ASTNodeType::CALL_EXPR) {
+                for (const uint32_t* child = flat.listBegin(node); child != flat.listEnd(node); child++) {
+                    assert(*child > i && *child < flat.nodes.size());
+                }
+            }
+        }
+    }
+    
+    std::cout << "test_flat_ast passed\n";
+}
+
+static std::string parseError(const std::string& source, ThreadPool* pool) {
+    TokenBuffer tokens = Lexer(source).tokenizePacked();
+    try {
+        if (pool) {
+            ParallelParser(tokens, *pool).parse();
+        } else {
+            Parser(tokens).parse();
+        }
+    } catch (const ParseError& e) {
+        return e.what();
+    }
+    return "";
+}
+
+void test_parallel_parse() {
+    ThreadPool pool(4);
+    std::string generated = "int counter;\n";
+    for (int i = 0; i < 200; i++) {
+        std::string n = std::to_string(i);
+        generated += "int f" + n + "(int a, char* s) {\n"
+                     "    int t[4];\n"
+                     "    while (a > " + n + ") { if (a % 2) { a = a - 1; } else { a = a / 2; } }\n"
+                     "    return f" + n + "(a + " + n + ", \"{\");\n"
+                     "}\n";
+        if (i % 10 == 0) {
+            generated += "const int limit" + n + " = " + n + ";\n";
+        }
+    }
+    std::vector<std::string> sources{generated, "int main() { return 0; }", ""};
+    for (const auto& entry : std::filesystem::directory_iterator("examples")) {
+        if (entry.path().extension() == ".sy") {
+            std::ifstream file(entry.path());
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            sources.push_back(buffer.str());
+        }
+    }
+    
+    for (const std::string& source : sources) {
+        TokenBuffer tokens = Lexer(source).tokenizePacked();
+        auto program = ParallelParser(tokens, pool).parse();
+        assert(irOf(program.get()) == irOf(source));
+    }
+    
+    // Errors match the serial parser's first error: in a body, before a
+    // body, and with unbalanced braces
+    std::string body_error = generated;
+    body_error.insert(body_error.find("int t[4];", body_error.size() / 2), "int = ;");
+    std::string late_error = body_error + "int broken(;\n";
+    std::string header_error = generated;
+    header_error.insert(header_error.find("int f150"), "int g(int) {}\n");
+    std::string unbalanced = generated + "}\n";
+    for (const std::string* source : {&body_error, &late_error, &header_error, &unbalanced}) {
+        std::string expected = parseError(*source, nullptr);
+        assert(!expected.empty());
+        assert(parseError(*source, &pool) == expected);
+    }
+    
+    std::cout << "test_parallel_parse passed\n";
+}
+
+void test_error_recovery() {
+    std::string source = "int main() {\n"
+                         "    int x = ;\n"
+                         "    if (x { x = 1; }\n"
+                         "    x = 2;\n"
+                         "    return x\n"
+                         "}\n"
+                         "int g(int) { return 1; }\n"
+                         "}\n"
+                         "int h() { return 2; }\n"
+                         "int k() { while (1) { x = (1; } return 3;\n";
+    
+    Lexer lexer(source);
+    Parser parser(lexer);
+    std::vector<std::string> errors;
+    auto program = parser.parse(errors);
+    
+    std::vector<std::string> expected = {
+        "Unexpected token in expression: ;",
+        "Expected ')' at line 3",
+        "Expected ';' at line 6",
+        "Expected parameter name at line 7",
+        "Unexpected token at top level: }",
+        "Expected ')' at line 10",
+        "Expected '}' at line 11",   // once, not again for the function body
+    };
+    assert(errors == expected);
+    
+    // What parsed is kept: main without its broken statements, and h
+    assert(program->declarations.size() == 2);
+    auto* main_func = dynamic_cast<FunctionDef*>(program->declarations[0]);
+    assert(main_func->body->statements.size() == 1);  // x = 2;
+    auto* h = dynamic_cast<FunctionDef*>(program->declarations[1]);
+    assert(h->name.toString() == "h");
+    
+    // Without an error list the first error is thrown as before
+    Lexer throw_lexer(source);
+    Parser throwing(throw_lexer);
+    std::string thrown;
+    try {
+        throwing.parse();
+    } catch (const ParseError& e) {
+        thrown = e.what();
+    }
+    assert(thrown == expected[0]);
+    
+    std::cout << "test_error_recovery passed\n";
+}
+
+void test_arena_reuse() {
+    std::string source = "int counter;\n";
+    for (int i = 0; i < 300; i++) {
+        std::string n = std::to_string(i);
+        source += "int f" + n + "(int a) { while (a > " + n + ") { a = a - 1; } return a * 2; }\n";
+    }
+    Lexer first_lexer(source);
+    Parser first(first_lexer);
+    auto program = first.parse();
+    size_t reserved = program->arena.bytesReserved();
+    assert(reserved > Arena::DEFAULT_BLOCK_SIZE);
+    
+    // A second unit of the same size fits in the first one's blocks
+    Lexer second_lexer(source);
+    Parser second(second_lexer);
+    second.reuseArena(std::move(program->arena));
+    program.reset();
+    auto reparsed = second.parse();
+    assert(reparsed->arena.bytesReserved() == reserved);
+    assert(reparsed->declarations.size() == 301);
+    
+    // A moved-from arena starts over with blocks of its own
+    Arena source_arena;
+    int* first_int = source_arena.make<int>(1);
+    Arena moved(std::move(source_arena));
+    assert(source_arena.bytesReserved() == 0 && source_arena.allocationCount() == 0);
+    int* fresh = source_arena.make<int>(2);
+    int* next = moved.make<int>(3);
+    assert(*first_int == 1 && *fresh == 2 && *next == 3 && fresh != next);
+    Arena assigned;
+    assigned = std::move(moved);
+    assert(moved.bytesReserved() == 0 && assigned.allocationCount() == 2);
+    
+    std::cout << "test_arena_reuse passed\n";
+}
+
 int main() {
     std::cout << "Running Parser Tests...\n";
     test_simple_function();
@@ -83,6 +461,14 @@ int main() {
     test_if_statement();
     test_while_statement();
     test_expressions();
+    test_streaming_from_lexer();
+    test_packed_tokens_and_error_line();
+    test_incremental_reparse();
+    test_precedence_and_nesting();
+    test_flat_ast();
+    test_parallel_parse();
+    test_error_recovery();
+    test_arena_reuse();
     std::cout << "All parser tests passed!\n";
     return 0;
 }